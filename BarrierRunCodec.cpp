@@ -0,0 +1,239 @@
+#include "BarrierRunCodec.h"
+
+static void writeVarint(vector<unsigned char> &data, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		data.push_back((unsigned char) (value | 0x80));
+		value >>= 7;
+	}
+	data.push_back((unsigned char) value);
+}
+
+// false when the varint is truncated or longer than 32 bits
+static bool readVarint(const unsigned char* &data, const unsigned char* end, uint32_t &value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35 && data < end; shift += 7)
+	{
+		unsigned char byte = *data++;
+		value |= (uint32_t) (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static void writeLittleEndian(unsigned char* data, uint32_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+	{
+		data[i] = (unsigned char) (value >> (8 * i));
+	}
+}
+
+static uint32_t readLittleEndian(const unsigned char* data, int bytes)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < bytes; i++)
+	{
+		value |= (uint32_t) data[i] << (8 * i);
+	}
+	return value;
+}
+
+BarrierRunEncoder::BarrierRunEncoder(int keyInterval): keyInterval(keyInterval), framesSinceKey(0), sequence(0)
+{
+}
+
+void BarrierRunEncoder::reset()
+{
+	columns.clear();
+}
+
+bool BarrierRunEncoder::encode(const signed char* barrierPoints, int count, vector<unsigned char> &packet)
+{
+	if (count < 0 || count > BARRIER_PACKET_MAX_COLUMNS)
+		return false;
+
+	bool key = (int) columns.size() != count || ++framesSinceKey >= keyInterval;
+	if (key)
+	{
+		columns.assign(count, 0);
+		framesSinceKey = 0;
+	}
+
+	//runs of the columns (key) or of the changed columns (delta), updating the previous columns on the way
+	packet.resize(BARRIER_PACKET_HEADER_SIZE);
+	unsigned char value = 0;
+	uint32_t run = 0;
+	bool changed = false;
+	for (int i = 0; i < count; i++)
+	{
+		unsigned char column = barrierPoints[i] != 0? 1 : 0;
+		unsigned char runValue = key? column : column ^ columns[i];
+		columns[i] = column;
+		if (runValue != value)
+		{
+			writeVarint(packet, run);
+			value = runValue;
+			run = 0;
+			changed = true;
+		}
+		run++;
+	}
+	writeVarint(packet, run);
+
+	if (!key && !changed)
+		return false;
+
+	packet[0] = BARRIER_PACKET_SYNC;
+	packet[1] = key? BARRIER_PACKET_KEY : BARRIER_PACKET_DELTA;
+	writeLittleEndian(&packet[2], sequence++, 2);
+	writeLittleEndian(&packet[4], count, 4);
+	writeLittleEndian(&packet[8], (uint32_t) (packet.size() - BARRIER_PACKET_HEADER_SIZE), 4);
+
+	unsigned char sum = 0;
+	for (int i = 0; i < BARRIER_PACKET_HEADER_SIZE - 1; i++)
+	{
+		sum += packet[i];
+	}
+	packet[BARRIER_PACKET_HEADER_SIZE - 1] = (unsigned char) -sum;
+
+	sum = 0;
+	for (size_t i = 0; i < packet.size(); i++)
+	{
+		sum += packet[i];
+	}
+	packet.push_back((unsigned char) -sum);
+	return true;
+}
+
+BarrierRunDecoder::BarrierRunDecoder(): synchronized(false), nextSequence(0), errors(0)
+{
+}
+
+const vector<unsigned char>& BarrierRunDecoder::getColumns()
+{
+	return columns;
+}
+
+bool BarrierRunDecoder::isSynchronized()
+{
+	return synchronized;
+}
+
+unsigned long BarrierRunDecoder::getErrors()
+{
+	return errors;
+}
+
+int BarrierRunDecoder::decode(const unsigned char* data, size_t size)
+{
+	buffer.insert(buffer.end(), data, data + size);
+
+	int applied = 0;
+	size_t start = 0;
+	while (start < buffer.size())
+	{
+		if (buffer[start] != BARRIER_PACKET_SYNC)
+		{
+			start++;
+			continue;
+		}
+		if (buffer.size() - start < BARRIER_PACKET_HEADER_SIZE)
+			break;
+
+		//headers are checked before their payload is waited for: column count up to the maximum,
+		//at most count + 1 runs, so a false sync byte can not hold the stream for long
+		unsigned char headerSum = 0;
+		for (size_t i = start; i < start + BARRIER_PACKET_HEADER_SIZE; i++)
+		{
+			headerSum += buffer[i];
+		}
+		size_t count = readLittleEndian(&buffer[start + 4], 4);
+		size_t payloadSize = readLittleEndian(&buffer[start + 8], 4);
+		if (headerSum != 0 || count > BARRIER_PACKET_MAX_COLUMNS || payloadSize > (count + 1) * BARRIER_PACKET_MAX_RUN_SIZE)
+		{
+			errors++;
+			start++;
+			continue;
+		}
+
+		size_t packetSize = BARRIER_PACKET_HEADER_SIZE + payloadSize + 1;
+		if (buffer.size() - start < packetSize)
+			break;
+
+		unsigned char sum = 0;
+		for (size_t i = start; i < start + packetSize; i++)
+		{
+			sum += buffer[i];
+		}
+		if (sum != 0 || !applyPacket(&buffer[start], packetSize))
+		{
+			//not a packet (or a damaged one), look for the next sync byte. A lost packet
+			//shows as a sequence gap of the next delta
+			errors++;
+			start++;
+			continue;
+		}
+
+		applied++;
+		start += packetSize;
+	}
+
+	buffer.erase(buffer.begin(), buffer.begin() + start);
+	return applied;
+}
+
+bool BarrierRunDecoder::applyPacket(const unsigned char* packet, size_t size)
+{
+	int type = packet[1];
+	uint16_t sequence = (uint16_t) readLittleEndian(&packet[2], 2);
+	uint32_t count = readLittleEndian(&packet[4], 4);
+	if (type != BARRIER_PACKET_KEY && type != BARRIER_PACKET_DELTA)
+		return false;
+
+	//deltas only apply to the columns of the previous packet
+	if (type == BARRIER_PACKET_DELTA && (!synchronized || sequence != nextSequence || count != columns.size()))
+	{
+		synchronized = false;
+		return true;
+	}
+
+	vector<unsigned char> runColumns(count, 0);
+	const unsigned char* data = packet + BARRIER_PACKET_HEADER_SIZE;
+	const unsigned char* end = packet + size - 1;
+	unsigned char value = 0;
+	uint32_t column = 0;
+	while (data < end)
+	{
+		uint32_t run;
+		if (!readVarint(data, end, run) || run > count - column)
+			return false;
+		for (uint32_t i = column; i < column + run; i++)
+		{
+			runColumns[i] = value;
+		}
+		column += run;
+		value ^= 1;
+	}
+	if (column != count)
+		return false;
+
+	if (type == BARRIER_PACKET_KEY)
+	{
+		columns.swap(runColumns);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			columns[i] ^= runColumns[i];
+		}
+	}
+
+	synchronized = true;
+	nextSequence = sequence + 1;
+	return true;
+}
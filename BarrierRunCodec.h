@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define BARRIER_PACKET_SYNC 0xb5
+#define BARRIER_PACKET_KEY 0
+#define BARRIER_PACKET_DELTA 1
+// sync, type, sequence (uint16), column count (uint32), payload size (uint32), header checksum
+#define BARRIER_PACKET_HEADER_SIZE 13
+// most columns of a packet, runs fit in 3 varint bytes and a payload in (columns + 1) * 3 bytes,
+// which bounds what a receiver buffers for a false sync byte
+#define BARRIER_PACKET_MAX_COLUMNS 65536
+#define BARRIER_PACKET_MAX_RUN_SIZE 3
+// a key packet every this many frames lets a receiver resynchronize after lost bytes
+#define BARRIER_PACKET_KEY_INTERVAL 120
+
+using namespace std;
+
+// Barrier column patterns as run length encoded packets, for barrier panels driven by a controller:
+// - packets: BARRIER_PACKET_SYNC, type, sequence, column count and payload size (little endian),
+//   a checksum byte making the header bytes sum to 0 (mod 256), the payload, then a checksum
+//   byte making all packet bytes sum to 0, so a receiver rejects false sync bytes at once
+// - payloads are run lengths (LEB128 varints) of alternating values, starting with 0
+//   (a first run of length 0 when the first column is 1)
+// - key packets encode the columns (1 transparent, 0 opaque), delta packets the columns that
+//   changed since the previous packet (1 flipped), so a static barrier costs nothing and a
+//   moving one a few bytes per boundary
+class BarrierRunEncoder
+{
+public:
+	BarrierRunEncoder(int keyInterval = BARRIER_PACKET_KEY_INTERVAL);
+
+	// barrier points (see ParallaxBarrier::getBarrierPoints), 'packet' receives the packet to send.
+	// False when the columns did not change and no key packet is due (nothing to send),
+	// or when 'count' exceeds BARRIER_PACKET_MAX_COLUMNS
+	bool encode(const signed char* barrierPoints, int count, vector<unsigned char> &packet);
+	// the next packet is a key packet
+	void reset();
+
+private:
+	int keyInterval;
+	int framesSinceKey;
+	uint16_t sequence;
+	vector<unsigned char> columns;
+};
+
+// BarrierRunDecoder rebuilds the column pattern from a byte stream of packets, bytes may arrive
+// in any split. Packets with a bad checksum are skipped up to the next sync byte, deltas after a
+// lost packet are ignored until the next key packet
+class BarrierRunDecoder
+{
+public:
+	BarrierRunDecoder();
+
+	// returns the number of packets applied to the pattern
+	int decode(const unsigned char* data, size_t size);
+
+	// 1 transparent, 0 opaque, empty before the first key packet
+	const vector<unsigned char>& getColumns();
+	bool isSynchronized();
+	unsigned long getErrors();
+
+private:
+	bool applyPacket(const unsigned char* packet, size_t size);
+
+	vector<unsigned char> buffer;
+	vector<unsigned char> columns;
+	bool synchronized;
+	uint16_t nextSequence;
+	unsigned long errors;
+};
@@ -0,0 +1,80 @@
+#include "BarrierSink.h"
+
+BarrierSink::BarrierSink(int keyInterval): encoder(keyInterval), started(false), packetCount(0), byteCount(0)
+{
+	MetricsRegistry &metrics = MetricsRegistry::get();
+	packetsMetric = &metrics.counter("parallax_barrier_sink_packets_total", "Barrier packets sent to the barrier sink");
+	bytesMetric = &metrics.counter("parallax_barrier_sink_bytes_total", "Bytes sent to the barrier sink");
+}
+
+BarrierSink::~BarrierSink()
+{
+}
+
+bool BarrierSink::start()
+{
+	stop();
+
+	//the receiver needs the whole pattern first
+	encoder.reset();
+	started = open();
+	return started;
+}
+
+void BarrierSink::stop()
+{
+	if (started)
+		close();
+	started = false;
+}
+
+bool BarrierSink::isStarted()
+{
+	return started;
+}
+
+void BarrierSink::requestKeyPacket()
+{
+	encoder.reset();
+}
+
+unsigned long BarrierSink::getPacketCount()
+{
+	return packetCount;
+}
+
+unsigned long long BarrierSink::getByteCount()
+{
+	return byteCount;
+}
+
+bool BarrierSink::send(const signed char* barrierPoints, int count)
+{
+	if (!started)
+		return false;
+	if (count > BARRIER_PACKET_MAX_COLUMNS)
+	{
+		ofLogError("BarrierSink") << count << " barrier columns exceed the packet maximum " << BARRIER_PACKET_MAX_COLUMNS << ", sink stopped";
+		stop();
+		return false;
+	}
+	if (!encoder.encode(barrierPoints, count, packet))
+		return true;
+
+	if (!write(&packet[0], packet.size()))
+	{
+		ofLogError("BarrierSink") << "could not write barrier packet, sink stopped";
+		stop();
+		return false;
+	}
+
+	return true;
+}
+
+void BarrierSink::countPacket(size_t size)
+{
+	packetCount++;
+	byteCount += size;
+	packetsMetric->increment();
+	bytesMetric->increment(size);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <atomic>
+
+#include "BarrierRunCodec.h"
+#include "Metrics.h"
+
+using namespace std;
+
+// BarrierSink sends the barrier of every composited frame to an external barrier panel
+// (e.g. a shutter panel driven by a microcontroller) instead of a monitor window:
+// - 'send' (render thread) encodes the barrier columns as run length packets (see BarrierRunEncoder),
+//   only columns that changed since the last packet are sent between periodic key packets
+// - sinks implement 'write' for their transport, and optionally 'open'/'close',
+//   they report each packet that actually left the sink with 'countPacket'
+// Every barrier row shows the same columns, so only one row is sent
+class BarrierSink
+{
+public:
+	BarrierSink(int keyInterval = BARRIER_PACKET_KEY_INTERVAL);
+	virtual ~BarrierSink();
+
+	bool start();
+	void stop();
+	bool isStarted();
+
+	// barrier points of the composited frame (see ParallaxBarrier::getBarrierPoints), 'count' entries.
+	// False when the packet could not be written, the sink is stopped then
+	virtual bool send(const signed char* barrierPoints, int count);
+
+	// packets (and their bytes) actually sent, dropped packets are not counted
+	unsigned long getPacketCount();
+	unsigned long long getByteCount();
+
+protected:
+	virtual bool open() { return true; };
+	virtual void close() {};
+	// writes a whole packet, should not block for long (it runs on the render thread).
+	// False stops the sink, a packet the sink chose to drop is not a failure
+	virtual bool write(const unsigned char* data, size_t size) = 0;
+	// the next packet holds all columns, for sinks that dropped packets
+	void requestKeyPacket();
+	// a packet of 'size' bytes was sent, can be called from any thread
+	void countPacket(size_t size);
+
+private:
+	BarrierRunEncoder encoder;
+	vector<unsigned char> packet;
+	bool started;
+
+	atomic<unsigned long> packetCount;
+	atomic<unsigned long long> byteCount;
+	MetricCounter* packetsMetric;
+	MetricCounter* bytesMetric;
+};
@@ -0,0 +1,273 @@
+#include "EyeTrace.h"
+
+#include <algorithm>
+#include <cstring>
+
+// records are padded to 8 bytes so record times stay aligned in the mapping
+static size_t getRecordSize(int stageCount)
+{
+	size_t size = sizeof(EyeTraceRecord) + (stageCount > 0? (1 + stageCount) * sizeof(uint32_t) : 0);
+	return (size + 7) & ~(size_t) 7;
+}
+
+EyeTraceWriter::EyeTraceWriter(): file(NULL), timings(false), recordSize(0), stopping(false), recordCount(0)
+{
+}
+
+EyeTraceWriter::~EyeTraceWriter()
+{
+	close();
+}
+
+bool EyeTraceWriter::open(const string &fileName, bool timings)
+{
+	close();
+
+	file = fopen(fileName.c_str(), "wb");
+	if (file == NULL)
+		return false;
+
+	this->timings = timings;
+	recordCount = 0;
+
+	EyeTraceHeader header;
+	memcpy(header.tag, EYE_TRACE_TAG, 4);
+	header.version = EYE_TRACE_VERSION;
+	header.stageCount = timings? FRAME_TIMING_STAGES : 0;
+	header.recordSize = (uint32_t) getRecordSize(header.stageCount);
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+	{
+		close();
+		return false;
+	}
+	recordSize = header.recordSize;
+
+	records.reserve(EYE_TRACE_WRITE_BUFFER_SIZE);
+	stopping = false;
+	writer = thread(&EyeTraceWriter::run, this);
+
+	return true;
+}
+
+void EyeTraceWriter::close()
+{
+	if (writer.joinable())
+	{
+		flush();
+		{
+			lock_guard<mutex> lock(writerMutex);
+			stopping = true;
+		}
+		writerCondition.notify_one();
+		writer.join();
+	}
+
+	if (file != NULL)
+		fclose(file);
+	file = NULL;
+	records.clear();
+	pendingRecords.clear();
+}
+
+bool EyeTraceWriter::isOpen()
+{
+	return file != NULL;
+}
+
+void EyeTraceWriter::record(unsigned long long time, ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition)
+{
+	FrameTiming frameTiming;
+	memset(&frameTiming, 0, sizeof(frameTiming));
+	record(time, leftEyePosition, rightEyePosition, frameTiming);
+}
+
+void EyeTraceWriter::record(unsigned long long time, ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, const FrameTiming &frameTiming)
+{
+	if (file == NULL)
+		return;
+
+	//the whole record is assembled first, the writer only receives complete records
+	uint64_t data[(sizeof(EyeTraceRecord) + (1 + FRAME_TIMING_STAGES) * sizeof(uint32_t) + 7) / 8];
+	memset(data, 0, sizeof(data));
+
+	EyeTraceRecord &eyeTraceRecord = *(EyeTraceRecord*) data;
+	eyeTraceRecord.time = time;
+	eyeTraceRecord.leftEyePosition[0] = leftEyePosition.x;
+	eyeTraceRecord.leftEyePosition[1] = leftEyePosition.y;
+	eyeTraceRecord.leftEyePosition[2] = leftEyePosition.z;
+	eyeTraceRecord.rightEyePosition[0] = rightEyePosition.x;
+	eyeTraceRecord.rightEyePosition[1] = rightEyePosition.y;
+	eyeTraceRecord.rightEyePosition[2] = rightEyePosition.z;
+
+	if (timings)
+	{
+		uint32_t* stages = (uint32_t*) (&eyeTraceRecord + 1);
+		stages[0] = (uint32_t) frameTiming.frameId;
+		for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+		{
+			stages[1 + stage] = (uint32_t) min(frameTiming.stages[stage], 0xffffffffULL);
+		}
+	}
+
+	records.insert(records.end(), (const unsigned char*) data, (const unsigned char*) data + recordSize);
+	if (records.size() >= EYE_TRACE_WRITE_BUFFER_SIZE)
+		flush();
+}
+
+void EyeTraceWriter::flush()
+{
+	if (records.empty())
+		return;
+
+	{
+		lock_guard<mutex> lock(writerMutex);
+		pendingRecords.insert(pendingRecords.end(), records.begin(), records.end());
+	}
+	writerCondition.notify_one();
+	records.clear();
+}
+
+unsigned long EyeTraceWriter::getRecordCount()
+{
+	lock_guard<mutex> lock(writerMutex);
+	return recordCount;
+}
+
+void EyeTraceWriter::run()
+{
+	vector<unsigned char> writeRecords;
+	unique_lock<mutex> lock(writerMutex);
+	while (true)
+	{
+		writerCondition.wait(lock, [this] { return stopping || !pendingRecords.empty(); });
+
+		writeRecords.swap(pendingRecords);
+		bool stopped = stopping;
+
+		lock.unlock();
+		size_t written = writeRecords.empty()? 0 : fwrite(&writeRecords[0], 1, writeRecords.size(), file);
+		if (written != writeRecords.size())
+			fprintf(stderr, "could not write eye trace records\n");
+		writeRecords.clear();
+		lock.lock();
+
+		//a failed write only loses its last partial record
+		recordCount += (unsigned long) (written / recordSize);
+
+		if (stopped && pendingRecords.empty())
+			return;
+	}
+}
+
+EyeTraceReader::EyeTraceReader(): records(NULL), recordSize(0), recordCount(0), stageCount(0)
+{
+}
+
+EyeTraceReader::~EyeTraceReader()
+{
+}
+
+bool EyeTraceReader::open(const string &fileName)
+{
+	close();
+
+	if (!file.open(fileName))
+		return false;
+
+	EyeTraceHeader header;
+	if (file.getSize() < sizeof(header))
+	{
+		close();
+		return false;
+	}
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (memcmp(header.tag, EYE_TRACE_TAG, 4) != 0 || header.version != EYE_TRACE_VERSION || header.stageCount > 0xffff || header.recordSize != getRecordSize(header.stageCount))
+	{
+		close();
+		return false;
+	}
+
+	records = file.getData() + sizeof(header);
+	recordSize = header.recordSize;
+	recordCount = (file.getSize() - sizeof(header)) / recordSize;
+	stageCount = (int) header.stageCount;
+
+	return true;
+}
+
+void EyeTraceReader::close()
+{
+	file.close();
+	records = NULL;
+	recordSize = 0;
+	recordCount = 0;
+	stageCount = 0;
+}
+
+bool EyeTraceReader::isOpen()
+{
+	return records != NULL;
+}
+
+size_t EyeTraceReader::getRecordCount()
+{
+	return recordCount;
+}
+
+const unsigned char* EyeTraceReader::getRecordData(size_t record)
+{
+	return records + record * recordSize;
+}
+
+const EyeTraceRecord& EyeTraceReader::getRecord(size_t record)
+{
+	return *(const EyeTraceRecord*) getRecordData(record);
+}
+
+size_t EyeTraceReader::findRecord(unsigned long long time)
+{
+	//binary search for the first later record
+	size_t first = 0, count = recordCount;
+	while (count > 0)
+	{
+		size_t step = count / 2;
+		if (getRecord(first + step).time <= time)
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+
+	return first > 0? first - 1 : 0;
+}
+
+unsigned long long EyeTraceReader::getDuration()
+{
+	return recordCount > 1? getRecord(recordCount - 1).time - getRecord(0).time : 0;
+}
+
+int EyeTraceReader::getStageCount()
+{
+	return stageCount;
+}
+
+unsigned long EyeTraceReader::getFrameId(size_t record)
+{
+	if (stageCount == 0)
+		return 0;
+
+	return ((const uint32_t*) (getRecordData(record) + sizeof(EyeTraceRecord)))[0];
+}
+
+unsigned long long EyeTraceReader::getStageTime(size_t record, int stage)
+{
+	if (stage < 0 || stage >= stageCount)
+		return 0;
+
+	return ((const uint32_t*) (getRecordData(record) + sizeof(EyeTraceRecord)))[1 + stage];
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ofVec3f.h"
+
+#include "FrameTimings.h"
+#include "MemoryMappedFile.h"
+
+#define EYE_TRACE_TAG "ETRC"
+#define EYE_TRACE_VERSION 1
+// queued records are handed to the writer thread in blocks of this size (or on flush/close)
+#define EYE_TRACE_WRITE_BUFFER_SIZE 65536
+
+using namespace std;
+
+// Eye trace files are append-only binary recordings of the eye positions used by each frame:
+// - a 16 byte header: EYE_TRACE_TAG, version, record size and stage count (all uint32),
+//   the stage count is 0 when the trace holds no frame timings
+// - fixed size records: EyeTraceRecord, followed (with timings) by the frame id and
+//   'stage count' stage times in microseconds (uint32 each), padded to 8 bytes
+// An interrupted recording only loses its last partial record
+struct EyeTraceHeader
+{
+	char tag[4];
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t stageCount;
+};
+
+struct EyeTraceRecord
+{
+	// ofGetElapsedTimeMicros, ascending
+	uint64_t time;
+	float leftEyePosition[3];
+	float rightEyePosition[3];
+
+	ofVec3f getLeftEyePosition() const { return ofVec3f(leftEyePosition[0], leftEyePosition[1], leftEyePosition[2]); }
+	ofVec3f getRightEyePosition() const { return ofVec3f(rightEyePosition[0], rightEyePosition[1], rightEyePosition[2]); }
+};
+
+// EyeTraceWriter queues records (called from the render thread), a writer thread writes them to the file
+class EyeTraceWriter
+{
+public:
+	EyeTraceWriter();
+	virtual ~EyeTraceWriter();
+
+	// creates (or replaces) 'fileName', records hold FRAME_TIMING_STAGES stage times when 'timings' is set
+	bool open(const string &fileName, bool timings = true);
+	void close();
+	bool isOpen();
+
+	void record(unsigned long long time, ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition);
+	// stage times are clamped to 32 bits, they are ignored when the trace has no timings
+	void record(unsigned long long time, ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, const FrameTiming &frameTiming);
+	// hands queued records to the writer thread without waiting for the write
+	void flush();
+
+	// records written to the file so far
+	unsigned long getRecordCount();
+
+private:
+	EyeTraceWriter(const EyeTraceWriter&);
+	EyeTraceWriter& operator=(const EyeTraceWriter&);
+
+	void run();
+
+	FILE* file;
+	bool timings;
+	size_t recordSize;
+
+	// records not yet handed to the writer thread (render thread only)
+	vector<unsigned char> records;
+
+	thread writer;
+	mutex writerMutex;
+	condition_variable writerCondition;
+	vector<unsigned char> pendingRecords;
+	bool stopping;
+	unsigned long recordCount;
+};
+
+// EyeTraceReader maps a trace file, records are read in place without copying or parsing
+class EyeTraceReader
+{
+public:
+	EyeTraceReader();
+	virtual ~EyeTraceReader();
+
+	bool open(const string &fileName);
+	void close();
+	bool isOpen();
+
+	size_t getRecordCount();
+	const EyeTraceRecord& getRecord(size_t record);
+	// last record at or before 'time', the first record when all records are later
+	size_t findRecord(unsigned long long time);
+	// time between the first and the last record
+	unsigned long long getDuration();
+
+	// stage count of the recording, 0 without timings (FrameTimingStage indices)
+	int getStageCount();
+	unsigned long getFrameId(size_t record);
+	unsigned long long getStageTime(size_t record, int stage);
+
+private:
+	const unsigned char* getRecordData(size_t record);
+
+	MemoryMappedFile file;
+	const unsigned char* records;
+	size_t recordSize;
+	size_t recordCount;
+	int stageCount;
+};
@@ -0,0 +1,74 @@
+#include "EyeTracker.h"
+
+EyeTracker::EyeTracker(): head(0)
+{
+}
+
+EyeTracker::~EyeTracker()
+{
+}
+
+void EyeTracker::start()
+{
+	startThread(false, false);
+}
+
+void EyeTracker::stop()
+{
+	waitForThread(true);
+}
+
+bool EyeTracker::getLatestSample(EyeTrackerSample &sample)
+{
+	while (true)
+	{
+		unsigned long end = head.load(memory_order_acquire);
+		if (end == 0)
+			return false;
+
+		sample = samples[(end - 1) & (EYE_TRACKER_RING_CAPACITY - 1)];
+
+		//retry if the producer wrapped around and may have overwritten the sample while copying
+		atomic_thread_fence(memory_order_acquire);
+		if (head.load(memory_order_relaxed) + 1 - (end - 1) <= EYE_TRACKER_RING_CAPACITY)
+			return true;
+	}
+}
+
+unsigned long EyeTracker::getSampleCount()
+{
+	return head.load(memory_order_acquire);
+}
+
+void EyeTracker::push(EyeTrackerSample &sample)
+{
+	if (sample.time == 0)
+		sample.time = ofGetElapsedTimeMicros();
+
+	unsigned long index = head.load(memory_order_relaxed);
+	samples[index & (EYE_TRACKER_RING_CAPACITY - 1)] = sample;
+
+	//publish the sample
+	head.store(index + 1, memory_order_release);
+}
+
+void EyeTracker::threadedFunction()
+{
+	if (!open())
+	{
+		ofLogError("EyeTracker") << "could not open eye tracker source";
+		return;
+	}
+
+	EyeTrackerSample sample;
+	while (isThreadRunning())
+	{
+		sample.time = 0;
+		if (!readSample(sample))
+			break;
+
+		push(sample);
+	}
+
+	close();
+}
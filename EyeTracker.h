@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <atomic>
+
+using namespace std;
+
+// ring capacity, must be a power of two
+#define EYE_TRACKER_RING_CAPACITY 64
+
+struct EyeTrackerSample
+{
+	// ofGetElapsedTimeMicros when the sample was captured, 
+	// sources that leave it at 0 get the time the sample was received
+	unsigned long long time;
+	ofVec3f leftEyePosition;
+	ofVec3f rightEyePosition;
+};
+
+// EyeTracker reads eye positions from a source in its own thread:
+// - the thread blocks on the source and pushes every sample into a single producer ring
+// - the render thread reads the newest sample without locking or waiting
+// Sources implement 'readSample', and optionally 'open'/'close' which run in the tracker thread
+class EyeTracker : public ofThread
+{
+public:
+	EyeTracker();
+	virtual ~EyeTracker();
+
+	void start();
+	void stop();
+
+	// newest sample, false while no sample has been received. Never blocks
+	bool getLatestSample(EyeTrackerSample &sample);
+	// samples received since the tracker started
+	unsigned long getSampleCount();
+
+protected:
+	virtual bool open() { return true; };
+	virtual void close() {};
+	// blocks until a sample is available, returns false when the source ends or fails
+	virtual bool readSample(EyeTrackerSample &sample) = 0;
+
+	void threadedFunction();
+
+private:
+	void push(EyeTrackerSample &sample);
+
+	EyeTrackerSample samples[EYE_TRACKER_RING_CAPACITY];
+	atomic<unsigned long> head;
+};
@@ -0,0 +1,88 @@
+#include "FileEyeTracker.h"
+
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+
+FileEyeTracker::FileEyeTracker(const string &fileName, bool loop): fileName(fileName), loop(loop), nextSample(0), replayStartTime(0)
+{
+}
+
+FileEyeTracker::~FileEyeTracker()
+{
+}
+
+bool FileEyeTracker::open()
+{
+	ifstream in(fileName.c_str());
+	if (!in)
+	{
+		ofLogError("FileEyeTracker") << "could not open '" << fileName << "'";
+		return false;
+	}
+
+	recordedSamples.clear();
+
+	string line;
+	while (getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		RecordedSample recordedSample;
+		istringstream values(line);
+		values >> recordedSample.time 
+			>> recordedSample.leftEyePosition.x >> recordedSample.leftEyePosition.y >> recordedSample.leftEyePosition.z
+			>> recordedSample.rightEyePosition.x >> recordedSample.rightEyePosition.y >> recordedSample.rightEyePosition.z;
+		if (values.fail())
+		{
+			ofLogError("FileEyeTracker") << "invalid sample '" << line << "' in '" << fileName << "'";
+			return false;
+		}
+
+		recordedSamples.push_back(recordedSample);
+	}
+
+	nextSample = 0;
+	replayStartTime = ofGetElapsedTimeMicros();
+
+	return !recordedSamples.empty();
+}
+
+bool FileEyeTracker::readSample(EyeTrackerSample &sample)
+{
+	if (nextSample == recordedSamples.size())
+	{
+		if (!loop)
+			return false;
+
+		//restart one mean sample period after the last sample,
+		//single sample or zero length traces would otherwise be replayed without any wait
+		double duration = recordedSamples.back().time - recordedSamples.front().time;
+		double period = recordedSamples.size() > 1? duration / (recordedSamples.size() - 1) : 0;
+		replayStartTime += (unsigned long long) (max(duration + period, FILE_EYE_TRACKER_MIN_LOOP_PERIOD) * 1000000.0);
+		nextSample = 0;
+	}
+
+	const RecordedSample &recordedSample = recordedSamples[nextSample];
+
+	//wait until the sample is due, sleeping in short steps so 'stop' is not delayed
+	unsigned long long dueTime = replayStartTime + (unsigned long long) ((recordedSample.time - recordedSamples.front().time) * 1000000.0);
+	unsigned long long now = ofGetElapsedTimeMicros();
+	while (now < dueTime)
+	{
+		if (!isThreadRunning())
+			return false;
+
+		this_thread::sleep_for(chrono::microseconds(min(dueTime - now, 10000ULL)));
+		now = ofGetElapsedTimeMicros();
+	}
+
+	sample.leftEyePosition = recordedSample.leftEyePosition;
+	sample.rightEyePosition = recordedSample.rightEyePosition;
+	sample.time = dueTime;
+	nextSample++;
+
+	return true;
+}
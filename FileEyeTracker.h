@@ -0,0 +1,37 @@
+#pragma once
+
+#include "EyeTracker.h"
+
+#include <vector>
+
+// restart period (seconds) of looped traces without duration, a nominal 60 Hz tracker
+#define FILE_EYE_TRACKER_MIN_LOOP_PERIOD (1.0 / 60.0)
+
+// FileEyeTracker replays a recorded eye trajectory at its original rate.
+// Files hold one sample per line: 'time lx ly lz rx ry rz' with time in seconds,
+// '#' starts a comment (same format as the offline renderer)
+class FileEyeTracker : public EyeTracker
+{
+public:
+	FileEyeTracker(const string &fileName, bool loop = true);
+	virtual ~FileEyeTracker();
+
+protected:
+	bool open();
+	bool readSample(EyeTrackerSample &sample);
+
+private:
+	struct RecordedSample
+	{
+		double time;
+		ofVec3f leftEyePosition;
+		ofVec3f rightEyePosition;
+	};
+
+	string fileName;
+	bool loop;
+
+	vector<RecordedSample> recordedSamples;
+	size_t nextSample;
+	unsigned long long replayStartTime;
+};
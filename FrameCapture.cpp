@@ -0,0 +1,340 @@
+#include "FrameCapture.h"
+
+#include <cstring>
+
+FrameCapture::FrameCapture(): file(NULL), content(FRAME_CAPTURE_PIXELS), screenSize(0), barrierSize(0), padding(0), screenWidth(0), screenHeight(0), barrierWidth(0), barrierHeight(0), barrierChannels(4), 
+	captureSlot(0), queueSlot(0), stopping(false), writeFailed(false), capturedFrames(0), droppedFrames(0)
+{
+	for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++)
+	{
+		slots[i].buffer = 0;
+		slots[i].fence = 0;
+		slots[i].data = NULL;
+		slots[i].state = SLOT_FREE;
+	}
+
+	MetricsRegistry &metrics = MetricsRegistry::get();
+	capturedFramesMetric = &metrics.counter("parallax_barrier_captured_frames_total", "Composited frames read back for capture");
+	droppedFramesMetric = &metrics.counter("parallax_barrier_capture_dropped_frames_total", "Composited frames not captured because every readback slot was in use");
+}
+
+FrameCapture::~FrameCapture()
+{
+	close();
+}
+
+bool FrameCapture::open(const string &fileName, ParallaxBarrier &parallaxBarrier, int content)
+{
+	close();
+
+	if (content == FRAME_CAPTURE_PIXELS && parallaxBarrier.isShaderCompositor())
+	{
+		ofLogWarning("FrameCapture") << "the shader compositor has no screen/barrier textures, capturing column maps";
+		content = FRAME_CAPTURE_COLUMN_MAPS;
+	}
+
+	this->content = content;
+	if (content == FRAME_CAPTURE_PIXELS)
+	{
+		screenWidth = (int) parallaxBarrier.getScreenTexture().getWidth();
+		screenHeight = (int) parallaxBarrier.getScreenTexture().getHeight();
+		barrierWidth = (int) parallaxBarrier.getBarrierTexture().getWidth();
+		barrierHeight = (int) parallaxBarrier.getBarrierTexture().getHeight();
+		//single channel barriers are read back as they are stored, RGBA would pad them with (0,0,1)
+		barrierChannels = parallaxBarrier.getBarrierFormat() == PARALLAX_BARRIER_BARRIER_R8? 1 : 4;
+		screenSize = (size_t) screenWidth * screenHeight * 4;
+		barrierSize = (size_t) barrierWidth * barrierHeight * barrierChannels;
+	}
+	else
+	{
+		screenWidth = parallaxBarrier.getScreenResolutionWidth() * parallaxBarrier.getSubpixelCount();
+		barrierWidth = parallaxBarrier.getBarrierResolutionWidth() * parallaxBarrier.getSubpixelCount();
+		screenHeight = barrierHeight = 1;
+		barrierChannels = 1;
+		screenSize = screenWidth;
+		barrierSize = barrierWidth;
+	}
+	padding = (8 - (screenSize + barrierSize) % 8) % 8;
+
+	file = fopen(fileName.c_str(), "wb");
+	if (file == NULL)
+	{
+		ofLogError("FrameCapture") << "could not create '" << fileName << "'";
+		return false;
+	}
+	//records are written whole, stdio buffering would only add a copy
+	setvbuf(file, NULL, _IONBF, 0);
+
+	FrameCaptureHeader header;
+	memcpy(header.tag, FRAME_CAPTURE_TAG, 4);
+	header.version = FRAME_CAPTURE_VERSION;
+	header.content = content;
+	header.recordSize = (uint32_t) (sizeof(FrameCaptureRecord) + screenSize + barrierSize + padding);
+	header.screenWidth = screenWidth;
+	header.screenHeight = screenHeight;
+	header.barrierWidth = barrierWidth;
+	header.barrierHeight = barrierHeight;
+	header.screenChannels = content == FRAME_CAPTURE_PIXELS? 4 : 1;
+	header.barrierChannels = barrierChannels;
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+	{
+		ofLogError("FrameCapture") << "could not write '" << fileName << "'";
+		fclose(file);
+		file = NULL;
+		return false;
+	}
+
+	for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++)
+	{
+		if (content == FRAME_CAPTURE_PIXELS)
+		{
+			//read by the CPU once, streamed from the GPU
+			glGenBuffers(1, &slots[i].buffer);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER, screenSize + barrierSize, NULL, GL_STREAM_READ);
+		}
+		else
+		{
+			slots[i].points.resize(screenSize + barrierSize);
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	captureSlot = queueSlot = 0;
+	stopping = false;
+	writeFailed = false;
+	capturedFrames = droppedFrames = 0;
+	startThread(false, false);
+	return true;
+}
+
+void FrameCapture::close()
+{
+	if (file == NULL)
+		return;
+
+	//readbacks already started are written before the writer stops
+	releaseWrittenSlots();
+	queueFinishedSlots(true);
+	{
+		lock_guard<std::mutex> lock(slotMutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+	waitForThread(true);
+
+	for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++)
+	{
+		Slot &slot = slots[i];
+		if (slot.fence != 0)
+			glDeleteSync(slot.fence);
+		if (slot.buffer != 0)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			if (slot.data != NULL)
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			glDeleteBuffers(1, &slot.buffer);
+		}
+		slot.buffer = 0;
+		slot.fence = 0;
+		slot.data = NULL;
+		slot.points.clear();
+		slot.state = SLOT_FREE;
+	}
+	queue.clear();
+
+	fclose(file);
+	file = NULL;
+}
+
+bool FrameCapture::isOpen()
+{
+	return file != NULL;
+}
+
+int FrameCapture::getContent()
+{
+	return content;
+}
+
+unsigned long FrameCapture::getCapturedFrames()
+{
+	return capturedFrames;
+}
+
+unsigned long FrameCapture::getDroppedFrames()
+{
+	return droppedFrames;
+}
+
+void FrameCapture::releaseWrittenSlots()
+{
+	lock_guard<std::mutex> lock(slotMutex);
+	for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++)
+	{
+		Slot &slot = slots[i];
+		if (slot.state != SLOT_WRITTEN)
+			continue;
+
+		if (slot.buffer != 0)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			slot.data = NULL;
+		}
+		slot.state = SLOT_FREE;
+	}
+}
+
+void FrameCapture::queueFinishedSlots(bool wait)
+{
+	bool queued = false;
+	while (true)
+	{
+		Slot &slot = slots[queueSlot];
+		{
+			lock_guard<std::mutex> lock(slotMutex);
+			if (slot.state != SLOT_PENDING)
+				break;
+		}
+
+		if (slot.fence != 0)
+		{
+			GLenum result = glClientWaitSync(slot.fence, wait? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait? 1000000000 : 0);
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+			{
+				if (!wait)
+					break;
+				ofLogWarning("FrameCapture") << "readback of frame " << slot.record.frameId << " did not complete";
+			}
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			slot.data = (const unsigned char*) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, screenSize + barrierSize, GL_MAP_READ_BIT);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		{
+			lock_guard<std::mutex> lock(slotMutex);
+			slot.state = SLOT_QUEUED;
+			queue.push_back(queueSlot);
+		}
+		queued = true;
+		queueSlot = (queueSlot + 1) % FRAME_CAPTURE_RING_SIZE;
+	}
+
+	if (queued)
+		queueCondition.notify_one();
+}
+
+void FrameCapture::capture(ParallaxBarrier &parallaxBarrier, unsigned long frameId, unsigned long long frameTime)
+{
+	if (file == NULL)
+		return;
+
+	releaseWrittenSlots();
+	queueFinishedSlots(false);
+
+	Slot &slot = slots[captureSlot];
+	{
+		lock_guard<std::mutex> lock(slotMutex);
+		if (slot.state != SLOT_FREE)
+		{
+			droppedFrames++;
+			droppedFramesMetric->increment();
+			return;
+		}
+	}
+
+	slot.record.time = frameTime;
+	slot.record.frameId = (uint32_t) frameId;
+	slot.record.phase = parallaxBarrier.getPhase();
+
+	if (content == FRAME_CAPTURE_PIXELS)
+	{
+		if (parallaxBarrier.getScreenTexture().getWidth() != screenWidth || parallaxBarrier.getBarrierTexture().getWidth() != barrierWidth ||
+			parallaxBarrier.getScreenTexture().getHeight() != screenHeight || parallaxBarrier.getBarrierTexture().getHeight() != barrierHeight)
+		{
+			ofLogError("FrameCapture") << "screen/barrier resolution changed, capture stopped";
+			close();
+			return;
+		}
+
+		//copies into the pixel pack buffer are queued on the GPU, glGetTexImage returns at once
+		ofTextureData &screenTexture = parallaxBarrier.getScreenTexture().getTextureData();
+		ofTextureData &barrierTexture = parallaxBarrier.getBarrierTexture().getTextureData();
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		//R8 barrier rows are not padded to 4 bytes
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glBindTexture(screenTexture.textureTarget, screenTexture.textureID);
+		glGetTexImage(screenTexture.textureTarget, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) 0);
+		glBindTexture(barrierTexture.textureTarget, barrierTexture.textureID);
+		glGetTexImage(barrierTexture.textureTarget, 0, barrierChannels == 1? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) screenSize);
+		glBindTexture(barrierTexture.textureTarget, 0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	else
+	{
+		if ((size_t) parallaxBarrier.getScreenResolutionWidth() * parallaxBarrier.getSubpixelCount() != screenSize ||
+			(size_t) parallaxBarrier.getBarrierResolutionWidth() * parallaxBarrier.getSubpixelCount() != barrierSize)
+		{
+			ofLogError("FrameCapture") << "screen/barrier resolution changed, capture stopped";
+			close();
+			return;
+		}
+
+		memcpy(&slot.points[0], parallaxBarrier.getScreenPoints(), screenSize);
+		memcpy(&slot.points[screenSize], parallaxBarrier.getBarrierPoints(), barrierSize);
+		slot.data = &slot.points[0];
+	}
+
+	{
+		lock_guard<std::mutex> lock(slotMutex);
+		slot.state = SLOT_PENDING;
+	}
+	captureSlot = (captureSlot + 1) % FRAME_CAPTURE_RING_SIZE;
+	capturedFrames++;
+	capturedFramesMetric->increment();
+
+	//column maps need no readback
+	if (content == FRAME_CAPTURE_COLUMN_MAPS)
+		queueFinishedSlots(false);
+}
+
+void FrameCapture::threadedFunction()
+{
+	static const unsigned char zeros[8] = { 0 };
+
+	while (true)
+	{
+		int slotIndex;
+		{
+			unique_lock<std::mutex> lock(slotMutex);
+			queueCondition.wait(lock, [&] { return stopping || !queue.empty(); });
+			if (queue.empty())
+				break;
+			slotIndex = queue.front();
+			queue.pop_front();
+		}
+
+		//the slot is only touched by this thread until it is marked written
+		Slot &slot = slots[slotIndex];
+		bool written = !writeFailed && slot.data != NULL &&
+			fwrite(&slot.record, sizeof(slot.record), 1, file) == 1 &&
+			fwrite(slot.data, screenSize + barrierSize, 1, file) == 1 &&
+			(padding == 0 || fwrite(zeros, padding, 1, file) == 1);
+		if (!written && !writeFailed)
+		{
+			ofLogError("FrameCapture") << "could not write frame " << slot.record.frameId << ", capture stopped";
+			writeFailed = true;
+		}
+
+		lock_guard<std::mutex> lock(slotMutex);
+		slot.state = SLOT_WRITTEN;
+	}
+}
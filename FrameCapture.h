@@ -0,0 +1,129 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include "ParallaxBarrier.h"
+#include "Metrics.h"
+
+#define FRAME_CAPTURE_TAG "FCAP"
+#define FRAME_CAPTURE_VERSION 2
+// frames read back ahead of the writer, a frame is dropped when every slot is in use
+#define FRAME_CAPTURE_RING_SIZE 4
+
+// capture contents
+// - PIXELS: screen and barrier textures, 8 bit rows bottom up with the channels of the header
+//   (RGBA for the screen, R for PARALLAX_BARRIER_BARRIER_R8 barriers, RGBA otherwise)
+// - COLUMN_MAPS: screen and barrier points (see ParallaxBarrier::getScreenPoints), one byte per entry
+#define FRAME_CAPTURE_PIXELS 0
+#define FRAME_CAPTURE_COLUMN_MAPS 1
+
+using namespace std;
+
+// Frame capture files are append-only binary recordings of the composited frames:
+// - a 40 byte header: FRAME_CAPTURE_TAG, version, content, record size, screen width/height,
+//   barrier width/height and screen/barrier channels (all uint32), column maps have a height of 1 and 1 channel
+// - fixed size records: FrameCaptureRecord, the screen data, then the barrier data, padded to 8 bytes
+struct FrameCaptureHeader
+{
+	char tag[4];
+	uint32_t version;
+	uint32_t content;
+	uint32_t recordSize;
+	uint32_t screenWidth;
+	uint32_t screenHeight;
+	uint32_t barrierWidth;
+	uint32_t barrierHeight;
+	uint32_t screenChannels;
+	uint32_t barrierChannels;
+};
+
+struct FrameCaptureRecord
+{
+	// ofGetElapsedTimeMicros of the frame start
+	uint64_t time;
+	// FramePacer frame id and barrier phase of the composited frame
+	uint32_t frameId;
+	uint32_t phase;
+};
+
+// FrameCapture records what was composited without stalling the render thread:
+// - 'capture' (render thread, after ParallaxBarrier::updateImages) starts an asynchronous readback
+//   of the screen and barrier textures into a pixel pack buffer of a slot ring and fences it
+// - later 'capture' calls map the buffers whose fence signaled and hand them to a writer thread,
+//   which streams them to the file; written buffers are unmapped on the next 'capture'
+// - without a free slot the frame is dropped (counted), rendering never waits for the GPU or disk
+// The shader compositor has no screen/barrier textures, its column maps are captured instead
+class FrameCapture : public ofThread
+{
+public:
+	FrameCapture();
+	virtual ~FrameCapture();
+
+	// creates (or replaces) 'fileName' for the current geometry of 'parallaxBarrier', needs the GL context
+	bool open(const string &fileName, ParallaxBarrier &parallaxBarrier, int content = FRAME_CAPTURE_PIXELS);
+	// waits for pending readbacks and writes them, needs the GL context
+	void close();
+	bool isOpen();
+	int getContent();
+
+	void capture(ParallaxBarrier &parallaxBarrier, unsigned long frameId, unsigned long long frameTime);
+
+	unsigned long getCapturedFrames();
+	unsigned long getDroppedFrames();
+
+protected:
+	void threadedFunction();
+
+private:
+	enum SlotState { SLOT_FREE, SLOT_PENDING, SLOT_QUEUED, SLOT_WRITTEN };
+
+	struct Slot
+	{
+		GLuint buffer;
+		GLsync fence;
+		FrameCaptureRecord record;
+		// mapped pixel buffer, or 'points' for column maps
+		const unsigned char* data;
+		vector<unsigned char> points;
+		SlotState state;
+	};
+
+	void releaseWrittenSlots();
+	// queues pending slots in capture order, 'wait' blocks on their fences
+	void queueFinishedSlots(bool wait);
+
+	FILE* file;
+	int content;
+	size_t screenSize;
+	size_t barrierSize;
+	size_t padding;
+	int screenWidth;
+	int screenHeight;
+	int barrierWidth;
+	int barrierHeight;
+	int barrierChannels;
+
+	Slot slots[FRAME_CAPTURE_RING_SIZE];
+	// next slot to capture into and next slot to hand to the writer
+	int captureSlot;
+	int queueSlot;
+
+	// ofThread has a member named mutex
+	std::mutex slotMutex;
+	condition_variable queueCondition;
+	deque<int> queue;
+	bool stopping;
+	bool writeFailed;
+
+	unsigned long capturedFrames;
+	unsigned long droppedFrames;
+	MetricCounter* capturedFramesMetric;
+	MetricCounter* droppedFramesMetric;
+};
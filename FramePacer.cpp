@@ -0,0 +1,60 @@
+#include "FramePacer.h"
+
+FramePacer::FramePacer(): compositedFrame(0), screenFrame(0), barrierFrame(0), pendingPresents(0), verticalSync(false)
+{
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+unsigned long FramePacer::beginFrame()
+{
+	pendingPresents = 0;
+	return ++compositedFrame;
+}
+
+void FramePacer::presentScreen(unsigned long frameId)
+{
+	//screen presents repeating a frame while waiting for the barrier window
+	if (frameId == screenFrame)
+		pendingPresents++;
+
+	screenFrame = frameId;
+}
+
+void FramePacer::presentBarrier(unsigned long frameId)
+{
+	barrierFrame = frameId;
+}
+
+bool FramePacer::isBarrierPending()
+{
+	// a barrier window that stopped drawing (e.g. minimized) must not stall the screen
+	return barrierFrame < compositedFrame && pendingPresents < FRAME_PACER_MAX_PENDING_PRESENTS;
+}
+
+unsigned long FramePacer::getCompositedFrame()
+{
+	return compositedFrame;
+}
+
+unsigned long FramePacer::getScreenFrame()
+{
+	return screenFrame;
+}
+
+unsigned long FramePacer::getBarrierFrame()
+{
+	return barrierFrame;
+}
+
+bool FramePacer::getVerticalSync()
+{
+	return verticalSync;
+}
+
+void FramePacer::setVerticalSync(bool verticalSync)
+{
+	this->verticalSync = verticalSync;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#define FRAME_PACER_MAX_PENDING_PRESENTS 4
+
+// FramePacer keeps the screen and barrier windows presenting the same frame:
+// - every composited frame gets a sequence id from 'beginFrame'
+// - each window reports the id it presented
+// - a new frame is only composited once the barrier window presented the previous one,
+//   in the meantime the screen window keeps presenting the last composited frame
+// With vertical sync only the screen window waits for vblank and the barrier window
+// presents right after it, so the pair runs at the full refresh rate. Vertical sync is a
+// setting of each window's context, windows apply it while drawing (their context is current)
+class FramePacer
+{
+public:
+	FramePacer();
+	virtual ~FramePacer();
+
+	unsigned long beginFrame();
+	void presentScreen(unsigned long frameId);
+	void presentBarrier(unsigned long frameId);
+
+	// true while the barrier window has not presented the last composited frame
+	bool isBarrierPending();
+
+	unsigned long getCompositedFrame();
+	unsigned long getScreenFrame();
+	unsigned long getBarrierFrame();
+
+	// vertical sync of the screen window, the barrier window never waits for vblank
+	bool getVerticalSync();
+	void setVerticalSync(bool verticalSync);
+
+private:
+	unsigned long compositedFrame;
+	unsigned long screenFrame;
+	unsigned long barrierFrame;
+	int pendingPresents;
+
+	bool verticalSync;
+};
@@ -0,0 +1,137 @@
+#include "FrameTimings.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <stdint.h>
+
+static const char* stageNames[FRAME_TIMING_STAGES] = { "eyeSampleAge", "model", "rasterization", "kernel", "scene", "present" };
+
+FrameTimings::FrameTimings(): head(0)
+{
+}
+
+FrameTimings::~FrameTimings()
+{
+}
+
+void FrameTimings::push(const FrameTiming &timing)
+{
+	unsigned long index = head.load(memory_order_relaxed);
+	entries[index & (FRAME_TIMINGS_CAPACITY - 1)] = timing;
+
+	//publish the entry
+	head.store(index + 1, memory_order_release);
+}
+
+void FrameTimings::snapshot(vector<FrameTiming> &timings)
+{
+	unsigned long end = head.load(memory_order_acquire);
+	unsigned long start = end > FRAME_TIMINGS_CAPACITY? end - FRAME_TIMINGS_CAPACITY : 0;
+
+	timings.clear();
+	timings.reserve(end - start);
+	for (unsigned long i = start; i < end; i++)
+	{
+		timings.push_back(entries[i & (FRAME_TIMINGS_CAPACITY - 1)]);
+	}
+
+	//drop entries the producer may have overwritten while copying,
+	//including the one it may be writing right now
+	atomic_thread_fence(memory_order_acquire);
+	unsigned long newEnd = head.load(memory_order_relaxed) + 1;
+	if (newEnd - start > FRAME_TIMINGS_CAPACITY)
+	{
+		unsigned long overwritten = min((unsigned long) timings.size(), newEnd - start - FRAME_TIMINGS_CAPACITY);
+		timings.erase(timings.begin(), timings.begin() + overwritten);
+	}
+}
+
+void FrameTimings::getPercentiles(const vector<FrameTiming> &timings, int stage, const float *percentiles, unsigned long long *values, int count)
+{
+	vector<unsigned long long> stageValues;
+	stageValues.reserve(timings.size());
+	for (vector<FrameTiming>::const_iterator it = timings.begin(), end = timings.end(); it != end; ++it)
+	{
+		stageValues.push_back(it->stages[stage]);
+	}
+
+	sort(stageValues.begin(), stageValues.end());
+
+	for (int i = 0; i < count; i++)
+	{
+		if (stageValues.empty())
+		{
+			values[i] = 0;
+		}
+		else
+		{
+			size_t index = (size_t) (percentiles[i] * (stageValues.size() - 1) + 0.5f);
+			values[i] = stageValues[min(index, stageValues.size() - 1)];
+		}
+	}
+}
+
+const char* FrameTimings::getStageName(int stage)
+{
+	return stageNames[stage];
+}
+
+bool FrameTimings::writeCsv(const string &fileName)
+{
+	vector<FrameTiming> timings;
+	snapshot(timings);
+
+	ofstream out(fileName.c_str(), ios::out | ios::trunc);
+	if (!out)
+		return false;
+
+	out << "frame,time";
+	for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+	{
+		out << ',' << stageNames[stage];
+	}
+	out << '\n';
+
+	for (vector<FrameTiming>::const_iterator it = timings.begin(), end = timings.end(); it != end; ++it)
+	{
+		out << it->frameId << ',' << it->frameTime;
+		for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+		{
+			out << ',' << it->stages[stage];
+		}
+		out << '\n';
+	}
+
+	return out.good();
+}
+
+bool FrameTimings::writeBinary(const string &fileName)
+{
+	vector<FrameTiming> timings;
+	snapshot(timings);
+
+	ofstream out(fileName.c_str(), ios::out | ios::trunc | ios::binary);
+	if (!out)
+		return false;
+
+	//fixed width fields, FrameTiming layout depends on the platform (unsigned long)
+	uint32_t header[4] = { 0, FRAME_TIMINGS_BINARY_VERSION, (2 + FRAME_TIMING_STAGES) * sizeof(uint64_t), FRAME_TIMING_STAGES };
+	memcpy(header, FRAME_TIMINGS_BINARY_TAG, 4);
+	out.write((const char*) header, sizeof(header));
+
+	vector<uint64_t> records;
+	records.reserve(timings.size() * (2 + FRAME_TIMING_STAGES));
+	for (vector<FrameTiming>::const_iterator it = timings.begin(), end = timings.end(); it != end; ++it)
+	{
+		records.push_back(it->frameId);
+		records.push_back(it->frameTime);
+		records.insert(records.end(), it->stages, it->stages + FRAME_TIMING_STAGES);
+	}
+	if (!records.empty())
+	{
+		out.write((const char*) &records[0], records.size() * sizeof(uint64_t));
+	}
+
+	return out.good();
+}
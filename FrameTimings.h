@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+// ring capacity, must be a power of two
+#define FRAME_TIMINGS_CAPACITY 1024
+#define FRAME_TIMINGS_BINARY_TAG "FTIM"
+#define FRAME_TIMINGS_BINARY_VERSION 2
+
+using namespace std;
+
+enum FrameTimingStage
+{
+	FRAME_TIMING_EYE_SAMPLE_AGE,	// eye sample time to frame start
+	FRAME_TIMING_MODEL,				// ParallaxBarrierModel update
+	FRAME_TIMING_RASTERIZATION,		// model points to column maps
+	FRAME_TIMING_KERNEL,			// barrier and screen kernels
+	FRAME_TIMING_SCENE,				// drawLeft/drawRight (or drawStereo) submission
+	FRAME_TIMING_PRESENT,			// frame start to screen present
+	FRAME_TIMING_STAGES
+};
+
+// all times in microseconds (ofGetElapsedTimeMicros)
+struct FrameTiming
+{
+	unsigned long frameId;
+	unsigned long long frameTime;
+	unsigned long long stages[FRAME_TIMING_STAGES];
+};
+
+// Lock-free ring of the last FRAME_TIMINGS_CAPACITY frame timings.
+// A single producer (the render thread) pushes, any thread can take snapshots;
+// entries overwritten while being copied are dropped from the snapshot
+class FrameTimings
+{
+public:
+	FrameTimings();
+	virtual ~FrameTimings();
+
+	void push(const FrameTiming &timing);
+	void snapshot(vector<FrameTiming> &timings);
+
+	// 'percentiles' in [0,1], 'values' receives one value per percentile
+	static void getPercentiles(const vector<FrameTiming> &timings, int stage, const float *percentiles, unsigned long long *values, int count);
+	static const char* getStageName(int stage);
+
+	bool writeCsv(const string &fileName);
+	// binary dump, little endian:
+	// - a 16 byte header: FRAME_TIMINGS_BINARY_TAG, version, record size and stage count (all uint32)
+	// - fixed size records: frame id, frame time and 'stage count' stage times (all uint64)
+	bool writeBinary(const string &fileName);
+
+private:
+	FrameTiming entries[FRAME_TIMINGS_CAPACITY];
+	atomic<unsigned long> head;
+};
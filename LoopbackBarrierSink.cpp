@@ -0,0 +1,45 @@
+#include "LoopbackBarrierSink.h"
+
+LoopbackBarrierSink::LoopbackBarrierSink(int keyInterval): BarrierSink(keyInterval), mismatches(0)
+{
+}
+
+LoopbackBarrierSink::~LoopbackBarrierSink()
+{
+	stop();
+}
+
+bool LoopbackBarrierSink::send(const signed char* barrierPoints, int count)
+{
+	if (!BarrierSink::send(barrierPoints, count))
+		return false;
+
+	const vector<unsigned char> &columns = decoder.getColumns();
+	bool matches = decoder.isSynchronized() && (int) columns.size() == count;
+	for (int i = 0; i < count && matches; i++)
+	{
+		matches = columns[i] == (barrierPoints[i] != 0? 1 : 0);
+	}
+	if (!matches)
+		mismatches++;
+	return true;
+}
+
+const vector<unsigned char>& LoopbackBarrierSink::getColumns()
+{
+	return decoder.getColumns();
+}
+
+unsigned long LoopbackBarrierSink::getMismatches()
+{
+	return mismatches;
+}
+
+bool LoopbackBarrierSink::write(const unsigned char* data, size_t size)
+{
+	if (decoder.decode(data, size) != 1)
+		return false;
+
+	countPacket(size);
+	return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "BarrierSink.h"
+
+// LoopbackBarrierSink stands in for a barrier controller: packets are decoded (BarrierRunDecoder) as
+// they are written, and the decoded columns are checked against the barrier points that were sent
+class LoopbackBarrierSink : public BarrierSink
+{
+public:
+	LoopbackBarrierSink(int keyInterval = BARRIER_PACKET_KEY_INTERVAL);
+	virtual ~LoopbackBarrierSink();
+
+	// same as BarrierSink::send, then compares the decoded columns with 'barrierPoints'
+	virtual bool send(const signed char* barrierPoints, int count);
+
+	// columns as the controller would show them
+	const vector<unsigned char>& getColumns();
+	// sent frames whose decoded columns differ from the barrier points
+	unsigned long getMismatches();
+
+protected:
+	bool write(const unsigned char* data, size_t size);
+
+private:
+	BarrierRunDecoder decoder;
+	unsigned long mismatches;
+};
@@ -0,0 +1,130 @@
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile(): data(NULL), size(0)
+{
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#else
+	fileDescriptor = -1;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	close();
+}
+
+bool MemoryMappedFile::open(const string &fileName)
+{
+	close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		close();
+		return false;
+	}
+	size = (size_t) fileSize.QuadPart;
+
+	//empty files can not be mapped, they are open without data
+	if (size == 0)
+		return true;
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+	{
+		close();
+		return false;
+	}
+
+	data = (const unsigned char*) MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+		return false;
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0)
+	{
+		close();
+		return false;
+	}
+	size = (size_t) fileStatus.st_size;
+
+	//empty files can not be mapped, they are open without data
+	if (size == 0)
+		return true;
+
+	void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	data = mapping != MAP_FAILED? (const unsigned char*) mapping : NULL;
+	if (data != NULL)
+		madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+
+	if (data == NULL)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MemoryMappedFile::close()
+{
+#ifdef _WIN32
+	if (data != NULL)
+		UnmapViewOfFile(data);
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#else
+	if (data != NULL)
+		munmap((void*) data, size);
+	if (fileDescriptor >= 0)
+		::close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+
+	data = NULL;
+	size = 0;
+}
+
+bool MemoryMappedFile::isOpen()
+{
+#ifdef _WIN32
+	return fileHandle != INVALID_HANDLE_VALUE;
+#else
+	return fileDescriptor >= 0;
+#endif
+}
+
+const unsigned char* MemoryMappedFile::getData()
+{
+	return data;
+}
+
+size_t MemoryMappedFile::getSize()
+{
+	return size;
+}
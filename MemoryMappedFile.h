@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+// read-only mapping of a whole file, pages are loaded by the OS on first access
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile();
+	virtual ~MemoryMappedFile();
+
+	bool open(const string &fileName);
+	void close();
+
+	bool isOpen();
+	const unsigned char* getData();
+	size_t getSize();
+
+private:
+	MemoryMappedFile(const MemoryMappedFile&);
+	MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+	const unsigned char* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
@@ -0,0 +1,317 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+MetricCounter::MetricCounter(const string &name, const string &labels, const string &help): name(name), labels(labels), help(help), value(0)
+{
+}
+
+void MetricCounter::increment(unsigned long long value)
+{
+	this->value.fetch_add(value, memory_order_relaxed);
+}
+
+unsigned long long MetricCounter::getValue()
+{
+	return value.load(memory_order_relaxed);
+}
+
+const string& MetricCounter::getName()
+{
+	return name;
+}
+
+const string& MetricCounter::getLabels()
+{
+	return labels;
+}
+
+const string& MetricCounter::getHelp()
+{
+	return help;
+}
+
+MetricHistogram::MetricHistogram(const string &name, const string &labels, const string &help, const unsigned long long *bounds, int boundCount): name(name), labels(labels), help(help), count(0), sum(0)
+{
+	this->boundCount = min(boundCount, METRICS_MAX_BUCKETS);
+	copy(bounds, bounds + this->boundCount, this->bounds);
+	for (int i = 0; i <= METRICS_MAX_BUCKETS; i++)
+	{
+		buckets[i].store(0, memory_order_relaxed);
+	}
+}
+
+void MetricHistogram::observe(unsigned long long value)
+{
+	int bucket = lower_bound(bounds, bounds + boundCount, value) - bounds;
+	buckets[bucket].fetch_add(1, memory_order_relaxed);
+	sum.fetch_add(value, memory_order_relaxed);
+	count.fetch_add(1, memory_order_relaxed);
+}
+
+unsigned long long MetricHistogram::getCount()
+{
+	return count.load(memory_order_relaxed);
+}
+
+unsigned long long MetricHistogram::getSum()
+{
+	return sum.load(memory_order_relaxed);
+}
+
+int MetricHistogram::getBucketCount()
+{
+	return boundCount;
+}
+
+unsigned long long MetricHistogram::getBucketBound(int bucket)
+{
+	return bounds[bucket];
+}
+
+unsigned long long MetricHistogram::getBucketValue(int bucket)
+{
+	return buckets[bucket].load(memory_order_relaxed);
+}
+
+const string& MetricHistogram::getName()
+{
+	return name;
+}
+
+const string& MetricHistogram::getLabels()
+{
+	return labels;
+}
+
+const string& MetricHistogram::getHelp()
+{
+	return help;
+}
+
+MetricsRegistry::MetricsRegistry()
+{
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+	for (vector<MetricCounter*>::iterator it = counters.begin(); it != counters.end(); ++it)
+	{
+		delete *it;
+	}
+	for (vector<MetricHistogram*>::iterator it = histograms.begin(); it != histograms.end(); ++it)
+	{
+		delete *it;
+	}
+}
+
+MetricsRegistry& MetricsRegistry::get()
+{
+	static MetricsRegistry registry;
+	return registry;
+}
+
+MetricCounter& MetricsRegistry::counter(const string &name, const string &help, const string &labels)
+{
+	lock_guard<mutex> lock(metricsMutex);
+	for (vector<MetricCounter*>::iterator it = counters.begin(); it != counters.end(); ++it)
+	{
+		if ((*it)->getName() == name && (*it)->getLabels() == labels)
+			return **it;
+	}
+
+	counters.push_back(new MetricCounter(name, labels, help));
+	return *counters.back();
+}
+
+MetricHistogram& MetricsRegistry::histogram(const string &name, const string &help, const unsigned long long *bounds, int boundCount, const string &labels)
+{
+	lock_guard<mutex> lock(metricsMutex);
+	for (vector<MetricHistogram*>::iterator it = histograms.begin(); it != histograms.end(); ++it)
+	{
+		if ((*it)->getName() == name && (*it)->getLabels() == labels)
+			return **it;
+	}
+
+	histograms.push_back(new MetricHistogram(name, labels, help, bounds, boundCount));
+	return *histograms.back();
+}
+
+void MetricsRegistry::getCounters(vector<MetricCounter*> &counters)
+{
+	lock_guard<mutex> lock(metricsMutex);
+	counters = this->counters;
+}
+
+void MetricsRegistry::getHistograms(vector<MetricHistogram*> &histograms)
+{
+	lock_guard<mutex> lock(metricsMutex);
+	histograms = this->histograms;
+}
+
+template <class Metric>
+static bool compareNames(Metric *first, Metric *second)
+{
+	return first->getName() < second->getName();
+}
+
+// 'name{labels,extra}' with empty parts left out
+static string formatSeries(const string &name, const string &labels, const string &extraLabel = "")
+{
+	string allLabels = labels.empty()? extraLabel : (extraLabel.empty()? labels : labels + "," + extraLabel);
+	return allLabels.empty()? name : name + "{" + allLabels + "}";
+}
+
+string MetricsRegistry::getPrometheusText()
+{
+	vector<MetricCounter*> counters;
+	vector<MetricHistogram*> histograms;
+	getCounters(counters);
+	getHistograms(histograms);
+
+	//help and type are written once per family, series of a family must be adjacent
+	stable_sort(counters.begin(), counters.end(), compareNames<MetricCounter>);
+	stable_sort(histograms.begin(), histograms.end(), compareNames<MetricHistogram>);
+
+	ostringstream out;
+	string lastName;
+	for (vector<MetricCounter*>::iterator it = counters.begin(); it != counters.end(); ++it)
+	{
+		if ((*it)->getName() != lastName)
+		{
+			out << "# HELP " << (*it)->getName() << " " << (*it)->getHelp() << "\n";
+			out << "# TYPE " << (*it)->getName() << " counter\n";
+			lastName = (*it)->getName();
+		}
+		out << formatSeries((*it)->getName(), (*it)->getLabels()) << " " << (*it)->getValue() << "\n";
+	}
+
+	lastName.clear();
+	for (vector<MetricHistogram*>::iterator it = histograms.begin(); it != histograms.end(); ++it)
+	{
+		MetricHistogram &histogram = **it;
+		if (histogram.getName() != lastName)
+		{
+			out << "# HELP " << histogram.getName() << " " << histogram.getHelp() << "\n";
+			out << "# TYPE " << histogram.getName() << " histogram\n";
+			lastName = histogram.getName();
+		}
+
+		//bucket values are cumulative in the exposition format
+		unsigned long long cumulative = 0;
+		for (int bucket = 0; bucket < histogram.getBucketCount(); bucket++)
+		{
+			cumulative += histogram.getBucketValue(bucket);
+			out << formatSeries(histogram.getName() + "_bucket", histogram.getLabels(), "le=\"" + to_string(histogram.getBucketBound(bucket)) + "\"") << " " << cumulative << "\n";
+		}
+		cumulative += histogram.getBucketValue(histogram.getBucketCount());
+		out << formatSeries(histogram.getName() + "_bucket", histogram.getLabels(), "le=\"+Inf\"") << " " << cumulative << "\n";
+		out << formatSeries(histogram.getName() + "_sum", histogram.getLabels()) << " " << histogram.getSum() << "\n";
+		out << formatSeries(histogram.getName() + "_count", histogram.getLabels()) << " " << histogram.getCount() << "\n";
+	}
+
+	return out.str();
+}
+
+bool MetricsRegistry::writePrometheus(const string &fileName)
+{
+	//written next to the destination and renamed, readers never see a partial file
+	string temporaryFileName = fileName + ".tmp";
+	{
+		ofstream out(temporaryFileName.c_str(), ios::out | ios::trunc);
+		if (!out)
+			return false;
+		out << getPrometheusText();
+		if (!out.good())
+			return false;
+	}
+
+#ifdef _WIN32
+	remove(fileName.c_str());
+#endif
+	return rename(temporaryFileName.c_str(), fileName.c_str()) == 0;
+}
+
+MetricsFileWriter::MetricsFileWriter(): stopping(false), interval(0)
+{
+}
+
+MetricsFileWriter::~MetricsFileWriter()
+{
+	stop();
+}
+
+void MetricsFileWriter::startThread()
+{
+	if (!writer.joinable())
+	{
+		stopping = false;
+		writer = thread(&MetricsFileWriter::run, this);
+	}
+}
+
+void MetricsFileWriter::start(const string &fileName, float interval)
+{
+	lock_guard<mutex> lock(writerMutex);
+	this->fileName = fileName;
+	this->interval = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(max(interval, 0.001f)));
+	startThread();
+	writerCondition.notify_one();
+}
+
+void MetricsFileWriter::stop()
+{
+	{
+		lock_guard<mutex> lock(writerMutex);
+		stopping = true;
+		fileName.clear();
+	}
+	writerCondition.notify_one();
+	if (writer.joinable())
+		writer.join();
+}
+
+void MetricsFileWriter::write(const string &fileName)
+{
+	lock_guard<mutex> lock(writerMutex);
+	pendingFileNames.push_back(fileName);
+	startThread();
+	writerCondition.notify_one();
+}
+
+void MetricsFileWriter::run()
+{
+	chrono::steady_clock::time_point nextWriteTime = chrono::steady_clock::now();
+	unique_lock<mutex> lock(writerMutex);
+	while (true)
+	{
+		//periodic writes wake up at the next write time, single dumps at once
+		if (fileName.empty())
+			writerCondition.wait(lock, [this] { return stopping || !pendingFileNames.empty() || !fileName.empty(); });
+		else
+			writerCondition.wait_until(lock, nextWriteTime, [this] { return stopping || !pendingFileNames.empty(); });
+
+		vector<string> fileNames;
+		fileNames.swap(pendingFileNames);
+		if (!fileName.empty() && chrono::steady_clock::now() >= nextWriteTime)
+		{
+			fileNames.push_back(fileName);
+			nextWriteTime = chrono::steady_clock::now() + interval;
+		}
+		bool stopped = stopping;
+
+		lock.unlock();
+		for (vector<string>::iterator it = fileNames.begin(); it != fileNames.end(); ++it)
+		{
+			if (!MetricsRegistry::get().writePrometheus(*it))
+				fprintf(stderr, "could not write metrics to %s\n", it->c_str());
+		}
+		lock.lock();
+
+		if (stopped && pendingFileNames.empty())
+			return;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define METRICS_MAX_BUCKETS 16
+
+using namespace std;
+
+// monotonic counter, safe to increment from any thread
+class MetricCounter
+{
+public:
+	MetricCounter(const string &name, const string &labels, const string &help);
+
+	void increment(unsigned long long value = 1);
+	unsigned long long getValue();
+
+	const string& getName();
+	const string& getLabels();
+	const string& getHelp();
+
+private:
+	string name;
+	string labels;
+	string help;
+	atomic<unsigned long long> value;
+};
+
+// histogram with fixed upper bounds (inclusive, ascending), safe to observe from any thread
+class MetricHistogram
+{
+public:
+	MetricHistogram(const string &name, const string &labels, const string &help, const unsigned long long *bounds, int boundCount);
+
+	void observe(unsigned long long value);
+
+	unsigned long long getCount();
+	unsigned long long getSum();
+	int getBucketCount();
+	unsigned long long getBucketBound(int bucket);
+	// observations up to the bucket bound, not cumulative
+	unsigned long long getBucketValue(int bucket);
+
+	const string& getName();
+	const string& getLabels();
+	const string& getHelp();
+
+private:
+	string name;
+	string labels;
+	string help;
+	int boundCount;
+	unsigned long long bounds[METRICS_MAX_BUCKETS];
+	// one more bucket for values above the last bound
+	atomic<unsigned long long> buckets[METRICS_MAX_BUCKETS + 1];
+	atomic<unsigned long long> count;
+	atomic<unsigned long long> sum;
+};
+
+// MetricsRegistry owns every metric of the process:
+// - metrics are created on first request and live as long as the process,
+//   callers keep the returned reference so updates are a single atomic operation
+// - the same name with different labels (e.g. 'stage="model"') is one metric family
+// - 'getPrometheusText' formats all metrics in the Prometheus text exposition format,
+//   'writePrometheus' writes it to a file (replaced at once, for textfile collectors)
+class MetricsRegistry
+{
+public:
+	static MetricsRegistry& get();
+
+	MetricCounter& counter(const string &name, const string &help, const string &labels = "");
+	MetricHistogram& histogram(const string &name, const string &help, const unsigned long long *bounds, int boundCount, const string &labels = "");
+
+	// snapshot of the registered metrics, for polling
+	void getCounters(vector<MetricCounter*> &counters);
+	void getHistograms(vector<MetricHistogram*> &histograms);
+
+	string getPrometheusText();
+	bool writePrometheus(const string &fileName);
+
+private:
+	MetricsRegistry();
+	~MetricsRegistry();
+	MetricsRegistry(const MetricsRegistry&);
+	MetricsRegistry& operator=(const MetricsRegistry&);
+
+	mutex metricsMutex;
+	vector<MetricCounter*> counters;
+	vector<MetricHistogram*> histograms;
+};
+
+// MetricsFileWriter writes the registry (MetricsRegistry::writePrometheus) from its own thread,
+// so file writes never run on the render thread:
+// - 'start' writes to a file every 'interval' seconds until 'stop'
+// - 'write' queues a single dump to another file
+class MetricsFileWriter
+{
+public:
+	MetricsFileWriter();
+	~MetricsFileWriter();
+
+	void start(const string &fileName, float interval);
+	// pending single dumps are still written
+	void stop();
+	void write(const string &fileName);
+
+private:
+	MetricsFileWriter(const MetricsFileWriter&);
+	MetricsFileWriter& operator=(const MetricsFileWriter&);
+
+	void startThread();
+	void run();
+
+	thread writer;
+	mutex writerMutex;
+	condition_variable writerCondition;
+	bool stopping;
+
+	string fileName;
+	chrono::steady_clock::duration interval;
+	vector<string> pendingFileNames;
+};
@@ -1,306 +1,696 @@
 #include "ParallaxBarrier.h"
 
-ParallaxBarrier::ParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection)
+#include "ofUtils.h"
+
+static const unsigned long long boundaryBuckets[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+
+static int getFlagSubpixelCount(int flags)
+{
+	return (flags & PARALLAX_BARRIER_SUBPIXEL)? 3 : 1;
+}
+
+static GLint getScreenInternalFormat(int screenFormat)
+{
+	switch (screenFormat)
+	{
+	case PARALLAX_BARRIER_SCREEN_RGB8:
+		return GL_RGB8;
+	case PARALLAX_BARRIER_SCREEN_RGB10:
+		return GL_RGB10;
+	default:
+		return GL_RGBA8;
+	}
+}
+
+ParallaxBarrier::ParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, int flags, float eyeResolutionScale, int screenFormat, int barrierFormat): _rasterizer(width, screenResolutionWidth * getFlagSubpixelCount(flags), barrierResolutionWidth * getFlagSubpixelCount(flags), spacing, position, viewDirection, upDirection)
 {
-	_width = width;
 	_height = height;
 	_screenResolutionWidth = screenResolutionWidth;
 	_screenResolutionHeight = screenResolutionHeight;
 	_barrierResolutionWidth = barrierResolutionWidth;
 	_barrierResolutionHeight = barrierResolutionHeight;
-	_spacing = spacing;
-	_position = position;
-	_viewDirection = viewDirection;
-	_upDirection = upDirection;
-	_screenInversePixelWidth = _screenResolutionWidth/_width;
-	_barrierInversePixelWidth = _barrierResolutionWidth/_width;
-	_modelScale = 1.f/spacing;
+	// the eye targets can only be narrower than the screen, and never empty
+	if (!(eyeResolutionScale > 0.f && eyeResolutionScale <= 1.f))
+	{
+		ofLogError("ParallaxBarrier") << "eye resolution scale " << eyeResolutionScale << " outside (0,1], using 1";
+		eyeResolutionScale = 1.f;
+	}
+	_eyeResolutionScale = eyeResolutionScale;
+	_eyeResolutionWidth = (int) ceil(screenResolutionWidth * eyeResolutionScale);
+	_flags = flags;
+	_screenFormat = screenFormat;
+	_barrierFormat = barrierFormat;
+	_modelTime = 0;
+	_rasterizationTime = 0;
+	_kernelTime = 0;
+
+	MetricsRegistry &metrics = MetricsRegistry::get();
+	_boundariesMetric = &metrics.histogram("parallax_barrier_boundaries", "Screen and barrier zone boundaries per model update", boundaryBuckets, sizeof(boundaryBuckets) / sizeof(boundaryBuckets[0]));
+	_guardPixelsMetric = &metrics.counter("parallax_barrier_guard_pixels_total", "Black guard pixels inserted between screen zones");
+	_modelFailuresMetric = &metrics.counter("parallax_barrier_model_failures_total", "Model updates without solution for the eye positions");
+	_iterationLimitMetric = &metrics.counter("parallax_barrier_model_iteration_limit_total", "Model updates stopped at PARALLAX_BARRIER_MAX_ITERATIONS");
+	_kernelErrorsMetric = &metrics.counter("parallax_barrier_kernel_errors_total", "OpenCL kernel executions that failed");
+	_compositedPixelsMetric = &metrics.counter("parallax_barrier_composited_pixels_total", "Screen pixels written by the screen kernel");
+
+	// OpenCL images can not be RGB and packed barriers are only read by the shader compositor
+	if (!isShaderCompositor() && _screenFormat != PARALLAX_BARRIER_SCREEN_RGBA8)
+	{
+		ofLogWarning("ParallaxBarrier") << "RGB screen formats need PARALLAX_BARRIER_SHADER_COMPOSITOR, using RGBA8";
+		_screenFormat = PARALLAX_BARRIER_SCREEN_RGBA8;
+	}
+	if (!isShaderCompositor() && _barrierFormat == PARALLAX_BARRIER_BARRIER_PACKED)
+	{
+		ofLogWarning("ParallaxBarrier") << "packed barriers need PARALLAX_BARRIER_SHADER_COMPOSITOR, using R8";
+		_barrierFormat = PARALLAX_BARRIER_BARRIER_R8;
+	}
+	if (isSubpixel() && _barrierFormat == PARALLAX_BARRIER_BARRIER_R8)
+	{
+		ofLogWarning("ParallaxBarrier") << "subpixel barriers need color channels, using RGBA8";
+		_barrierFormat = PARALLAX_BARRIER_BARRIER_RGBA8;
+	}
 
 	// kernel loading and OpenCL kernel creation
-	_screenKernel = new OpenCLKernel("opencl/kernel/screenKernel.cl", "updateScreenPixels");
-	_barrierKernel = new OpenCLKernel("opencl/kernel/barrierKernel.cl", "updateBarrierPixels");
+	_screenKernel = NULL;
+	_barrierKernel = NULL;
+	if (!isShaderCompositor())
+	{
+		string kernelSuffix = isSubpixel()? "Subpixel" : "";
+		_screenKernel = new OpenCLKernel("opencl/kernel/screenKernel.cl", (isLayeredStereo()? "updateScreenPixelsLayered" : "updateScreenPixels") + kernelSuffix);
+		_barrierKernel = new OpenCLKernel("opencl/kernel/barrierKernel.cl", "updateBarrierPixels" + kernelSuffix);
+	}
 
-	// images initialization after OpenCL contexts are created
-	_barrierImage.allocate(barrierResolutionWidth, barrierResolutionHeight, OF_IMAGE_COLOR_ALPHA);
-	_screenImage.allocate(screenResolutionWidth, screenResolutionHeight, OF_IMAGE_COLOR_ALPHA);
-	_screenLeftImage.allocate(screenResolutionWidth, screenResolutionHeight, OF_IMAGE_COLOR_ALPHA);
-	_screenRightImage.allocate(screenResolutionWidth, screenResolutionHeight, OF_IMAGE_COLOR_ALPHA);
+	// images initialization after OpenCL contexts are created,
+	// the shader compositor draws screen and barrier without them
+	if (!isShaderCompositor())
+	{
+		GLint barrierInternalFormat = _barrierFormat == PARALLAX_BARRIER_BARRIER_R8? GL_R8 : GL_RGBA8;
+		if (isSingleRowBarrier())
+		{
+			// columns are stretched vertically when drawn, nearest filtering keeps them sharp
+			_barrierTexture.allocate(barrierResolutionWidth, 1, barrierInternalFormat);
+			_barrierTexture.setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+		}
+		else
+		{
+			_barrierTexture.allocate(barrierResolutionWidth, barrierResolutionHeight, barrierInternalFormat);
+		}
+		if (_barrierFormat == PARALLAX_BARRIER_BARRIER_R8)
+		{
+			// the red channel is drawn as gray, opaque
+			GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+			glBindTexture(_barrierTexture.getTextureData().textureTarget, _barrierTexture.getTextureData().textureID);
+			glTexParameteriv(_barrierTexture.getTextureData().textureTarget, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+			glBindTexture(_barrierTexture.getTextureData().textureTarget, 0);
+		}
+		_screenTexture.allocate(screenResolutionWidth, screenResolutionHeight, GL_RGBA8);
+	}
+	if (isPixelReadback() && !isShaderCompositor())
+	{
+		// CPU only images, filled from the textures by readPixels
+		_barrierImage.setUseTexture(false);
+		_barrierImage.allocate(barrierResolutionWidth, isSingleRowBarrier()? 1 : barrierResolutionHeight, _barrierFormat == PARALLAX_BARRIER_BARRIER_R8? OF_IMAGE_GRAYSCALE : OF_IMAGE_COLOR_ALPHA);
+		_screenImage.setUseTexture(false);
+		_screenImage.allocate(screenResolutionWidth, screenResolutionHeight, OF_IMAGE_COLOR_ALPHA);
+	}
+	_screenStereoTexture = 0;
+	if (isLayeredStereo())
+	{
+		// both views live in one layered texture, left/right images are not used
+		glGenTextures(1, &_screenStereoTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _screenStereoTexture);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, getScreenInternalFormat(_screenFormat), _eyeResolutionWidth, screenResolutionHeight, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	else
+	{
+		_screenLeftTexture.allocate(_eyeResolutionWidth, screenResolutionHeight, getScreenInternalFormat(_screenFormat));
+		_screenRightTexture.allocate(_eyeResolutionWidth, screenResolutionHeight, getScreenInternalFormat(_screenFormat));
+	}
 
 	//OpenCL data initialization
 	_screenKernelLocalSize[0] = 16;
 	_screenKernelLocalSize[1] = 16;
-	_screenKernelGlobalSize[0] = _screenKernelLocalSize[0] * ceil( ((float) _screenImage.width) / (float) _screenKernelLocalSize[0] );
-	_screenKernelGlobalSize[1] = _screenKernelLocalSize[1] * ceil( ((float) _screenImage.height) / (float) _screenKernelLocalSize[1] );
-
-	_barrierKernelLocalSize[0] = 16;
-	_barrierKernelLocalSize[1] = 16;
-	_barrierKernelGlobalSize[0] = _screenKernelLocalSize[0] * ceil( ((float) _barrierImage.width) / (float) _barrierKernelLocalSize[0] );
-	_barrierKernelGlobalSize[1] = _screenKernelLocalSize[1] * ceil( ((float) _barrierImage.height) / (float) _barrierKernelLocalSize[1] );
+	_screenKernelGlobalSize[0] = _screenKernelLocalSize[0] * ceil( ((float) _screenResolutionWidth) / (float) _screenKernelLocalSize[0] );
+	_screenKernelGlobalSize[1] = _screenKernelLocalSize[1] * ceil( ((float) _screenResolutionHeight) / (float) _screenKernelLocalSize[1] );
+
+	_barrierKernelLocalSize[0] = isSingleRowBarrier()? 256 : 16;
+	_barrierKernelLocalSize[1] = isSingleRowBarrier()? 1 : 16;
+	_barrierKernelGlobalSize[0] = _barrierKernelLocalSize[0] * ceil( ((float) _barrierResolutionWidth) / (float) _barrierKernelLocalSize[0] );
+	_barrierKernelGlobalSize[1] = isSingleRowBarrier()? 1 : _barrierKernelLocalSize[1] * ceil( ((float) _barrierResolutionHeight) / (float) _barrierKernelLocalSize[1] );
+
+	_phaseCount = 1;
+	_phase = 0;
+	_phasePointsValid = false;
+	_phaseInvertedBarrier = false;
+	_phaseScreenPoints = new cl_char[_rasterizer.getScreenResolutionWidth()];
+	_phaseBarrierPoints = new cl_char[_rasterizer.getBarrierResolutionWidth()];
+	fill_n(_phaseScreenPoints, _rasterizer.getScreenResolutionWidth(), 0);
+	fill_n(_phaseBarrierPoints, _rasterizer.getBarrierResolutionWidth(), 0);
+
+	_screenPoints = new cl_char[_rasterizer.getScreenResolutionWidth()];
+	_barrierPoints = new cl_char[_rasterizer.getBarrierResolutionWidth()];
+	copyPoints();
+
+	_damageTracking = false;
+	_compositedScreenPoints = new cl_char[_rasterizer.getScreenResolutionWidth()];
+	_compositedBarrierPoints = new cl_char[_rasterizer.getBarrierResolutionWidth()];
+	_compositedPointsValid = false;
+
+	_pipeline = NULL;
+	_pipelineGeneration = 0;
+	_pipelineErrorRatio = 0;
+	if (flags & PARALLAX_BARRIER_PIPELINED)
+	{
+		setPipelined(true);
+	}
 
-	_screenPoints = new cl_char[screenResolutionWidth];
-	_barrierPoints = new cl_char[barrierResolutionWidth];
+	_screenPointsBuffer = NULL;
+	_barrierPointsBuffer = NULL;
+	_leftImageTexture = NULL;
+	_rightImageTexture = NULL;
+	_stereoImageTexture = NULL;
+	_screenImageTexture = NULL;
+	_barrierImageTexture = NULL;
+	_screenCompositor = NULL;
+	_barrierCompositor = NULL;
+	_screenPointsTexture = 0;
+	_barrierPointsTexture = 0;
+	_packedBarrierPoints = NULL;
+	_packedBarrierWidth = 0;
+
+	if (isShaderCompositor())
+	{
+		initializeCompositor();
+	}
+	else
+	{
+		initializeKernels();
+	}
+}
 
-	_screenPointsBuffer = new OpenCLBuffer(_screenPoints, _screenResolutionWidth * sizeof(cl_char));
+void ParallaxBarrier::initializeKernels()
+{
+	_screenPointsBuffer = new OpenCLBuffer(_screenPoints, _rasterizer.getScreenResolutionWidth() * sizeof(cl_char));
 	_screenKernelReadBuffers.push_back(_screenPointsBuffer);
 
-	_barrierPointsBuffer = new OpenCLBuffer(_barrierPoints, _barrierResolutionWidth * sizeof(cl_char));
+	_barrierPointsBuffer = new OpenCLBuffer(_barrierPoints, _rasterizer.getBarrierResolutionWidth() * sizeof(cl_char));
 	_barrierKernelReadBuffers.push_back(_barrierPointsBuffer);
 
-	_leftImageTexture = new OpenCLTexture(_screenLeftImage.getTextureReference().getTextureData().textureID, _screenLeftImage.getTextureReference().getTextureData().textureTarget);
-	_screenKernelReadTextures.push_back(_leftImageTexture);
-	_rightImageTexture = new OpenCLTexture(_screenRightImage.getTextureReference().getTextureData().textureID, _screenRightImage.getTextureReference().getTextureData().textureTarget);
-	_screenKernelReadTextures.push_back(_rightImageTexture);
+	if (isLayeredStereo())
+	{
+		_stereoImageTexture = new OpenCLTexture(_screenStereoTexture, GL_TEXTURE_2D_ARRAY);
+		_screenKernelReadTextures.push_back(_stereoImageTexture);
+	}
+	else
+	{
+		_leftImageTexture = new OpenCLTexture(_screenLeftTexture.getTextureData().textureID, _screenLeftTexture.getTextureData().textureTarget);
+		_screenKernelReadTextures.push_back(_leftImageTexture);
+		_rightImageTexture = new OpenCLTexture(_screenRightTexture.getTextureData().textureID, _screenRightTexture.getTextureData().textureTarget);
+		_screenKernelReadTextures.push_back(_rightImageTexture);
+	}
 
-	_screenImageTexture = new OpenCLTexture(_screenImage.getTextureReference().getTextureData().textureID, _screenImage.getTextureReference().getTextureData().textureTarget);
+	_screenImageTexture = new OpenCLTexture(_screenTexture.getTextureData().textureID, _screenTexture.getTextureData().textureTarget);
 	_screenKernelWriteTextures.push_back(_screenImageTexture);
 
-	_barrierImageTexture = new OpenCLTexture(_barrierImage.getTextureReference().getTextureData().textureID, _barrierImage.getTextureReference().getTextureData().textureTarget);
+	_barrierImageTexture = new OpenCLTexture(_barrierTexture.getTextureData().textureID, _barrierTexture.getTextureData().textureTarget);
 	_barrierKernelWriteTextures.push_back(_barrierImageTexture);
 
 	_screenKernel->defineArguments(NULL, &_screenKernelReadBuffers, NULL, &_screenKernelReadTextures, &_screenKernelWriteTextures);
 	_barrierKernel->defineArguments(NULL, &_barrierKernelReadBuffers, NULL, NULL, &_barrierKernelWriteTextures);
-	
-	// initialize model transormation
-	updateModelTransformation();
-	_model.setWidth(_width*_modelScale);
+}
+
+void ParallaxBarrier::initializeCompositor()
+{
+	//column maps are signed integer textures read with texelFetch
+	glGenTextures(1, &_screenPointsTexture);
+	glBindTexture(GL_TEXTURE_2D, _screenPointsTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8I, _rasterizer.getScreenResolutionWidth(), 1, 0, GL_RED_INTEGER, GL_BYTE, _screenPoints);
+	glGenTextures(1, &_barrierPointsTexture);
+	glBindTexture(GL_TEXTURE_2D, _barrierPointsTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	if (_barrierFormat == PARALLAX_BARRIER_BARRIER_PACKED)
+	{
+		// 8 barrier columns (subpixels) per texel, column i is bit i % 8 of texel i / 8
+		_packedBarrierWidth = (_rasterizer.getBarrierResolutionWidth() + 7) / 8;
+		_packedBarrierPoints = new unsigned char[_packedBarrierWidth];
+		fill_n(_packedBarrierPoints, _packedBarrierWidth, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, _packedBarrierWidth, 1, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, _packedBarrierPoints);
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8I, _rasterizer.getBarrierResolutionWidth(), 1, 0, GL_RED_INTEGER, GL_BYTE, _barrierPoints);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	string header;
+	if (isLayeredStereo())
+	{
+		header = "#define LAYERED_STEREO";
+	}
+	else if (_screenLeftTexture.getTextureData().textureTarget != GL_TEXTURE_2D)
+	{
+		header = "#define EYE_TEXTURE_RECTANGLE";
+	}
+
+	string barrierHeader = _barrierFormat == PARALLAX_BARRIER_BARRIER_PACKED? "#define PACKED_BARRIER" : "";
+	if (isSubpixel())
+	{
+		header += "\n#define SUBPIXEL";
+		barrierHeader += "\n#define SUBPIXEL";
+	}
+
+	_screenCompositor = new OpenGLShader("opengl/shader/compositor.vert", "opengl/shader/screenCompositor.frag", "", header);
+	_barrierCompositor = new OpenGLShader("opengl/shader/compositor.vert", "opengl/shader/barrierCompositor.frag", "", barrierHeader);
 }
 
 ParallaxBarrier::~ParallaxBarrier()
 {
+	setPipelined(false);
+
 	delete _screenKernel;
 	delete _barrierKernel;
-	delete _screenPoints;
-	delete _barrierPoints;
+	delete[] _screenPoints;
+	delete[] _barrierPoints;
+	delete[] _compositedScreenPoints;
+	delete[] _compositedBarrierPoints;
+	delete[] _phaseScreenPoints;
+	delete[] _phaseBarrierPoints;
 
 	delete _screenPointsBuffer;
 	delete _barrierPointsBuffer;
 	delete _leftImageTexture;
 	delete _rightImageTexture;
+	delete _stereoImageTexture;
 	delete _screenImageTexture;
 	delete _barrierImageTexture;
+
+	delete _screenCompositor;
+	delete _barrierCompositor;
+	delete[] _packedBarrierPoints;
+
+	if (_screenStereoTexture != 0)
+	{
+		glDeleteTextures(1, &_screenStereoTexture);
+	}
+	if (_screenPointsTexture != 0)
+	{
+		glDeleteTextures(1, &_screenPointsTexture);
+		glDeleteTextures(1, &_barrierPointsTexture);
+	}
 }
 
 void ParallaxBarrier::update(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier)
 {
-	errorRatio = 0;
+	updatePoints(leftEyePosition, rightEyePosition, invertedBarrier);
+	updateImages();
+}
 
-	ofVec3f modelLeftEyePosition3d = leftEyePosition * _modelTransformation;
-	ofVec3f modelRightEyePosition3d = rightEyePosition * _modelTransformation;
+void ParallaxBarrier::updatePoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier)
+{
+	if (_pipeline != NULL)
+	{
+		updatePipelinedPoints(leftEyePosition, rightEyePosition, invertedBarrier);
+	}
+	else if (!_phasePointsValid || leftEyePosition != _phaseLeftEyePosition || rightEyePosition != _phaseRightEyePosition || invertedBarrier != _phaseInvertedBarrier)
+	{
+		updatePhasePoints(leftEyePosition, rightEyePosition, invertedBarrier);
+	}
+	else
+	{
+		//maps of the selected phase are already computed
+		_modelTime = 0;
+		_rasterizationTime = 0;
+	}
 
-	_modelLeftEyePosition = ofVec2f(modelLeftEyePosition3d.x, modelLeftEyePosition3d.z);
-	_modelRightEyePosition = ofVec2f(modelRightEyePosition3d.x, modelRightEyePosition3d.z);
+	copyPoints();
+}
+
+void ParallaxBarrier::updatePhasePoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier)
+{
+	int screenWidth = _rasterizer.getScreenResolutionWidth();
+	int barrierWidth = _rasterizer.getBarrierResolutionWidth();
+
+	_modelTime = 0;
+	_rasterizationTime = 0;
 
-	//modify model for new eye positions
-	_model.update(_modelLeftEyePosition, _modelRightEyePosition);
+	for (int phase = 0; phase < _phaseCount; phase++)
+	{
+		//shifts of one or more zones swap left and right zones
+		float zoneShift = 2.f * phase / _phaseCount;
+		bool phaseInverted = zoneShift >= 1.f;
+
+		if (!_rasterizer.update(leftEyePosition, rightEyePosition, invertedBarrier != phaseInverted, fmod(zoneShift, 1.f)))
+		{
+			_modelFailuresMetric->increment();
+			if (_rasterizer.getModel().isIterationLimitReached())
+				_iterationLimitMetric->increment();
+		}
+		_modelTime += _rasterizer.getModelTime();
+		_rasterizationTime += _rasterizer.getRasterizationTime();
+		_boundariesMetric->observe(_rasterizer.getModel().getScreenPoints().size() + _rasterizer.getModel().getBarrierPoints().size());
+		_guardPixelsMetric->increment(_rasterizer.getErrorRatio());
 
-	//modify pixels
-	updatePixels(invertedBarrier);
+		copy(_rasterizer.getScreenPoints(), _rasterizer.getScreenPoints() + screenWidth, _phaseScreenPoints + phase * screenWidth);
+		copy(_rasterizer.getBarrierPoints(), _rasterizer.getBarrierPoints() + barrierWidth, _phaseBarrierPoints + phase * barrierWidth);
+	}
+
+	_phaseLeftEyePosition = leftEyePosition;
+	_phaseRightEyePosition = rightEyePosition;
+	_phaseInvertedBarrier = invertedBarrier;
+	_phasePointsValid = true;
 }
 
-void ParallaxBarrier::updateModelTransformation()
+void ParallaxBarrier::updatePipelinedPoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier)
 {
-	ofMatrix4x4 modelScale, modelRotation, modelUpRotation, modelTranslation, modelCenterTranslation;
-	modelScale.makeScaleMatrix(_modelScale, _modelScale, _modelScale);
+	//'_phasePointsValid' is reset by geometry and phase count changes, maps of older generations are not used
+	if (!_phasePointsValid)
+	{
+		_pipelineGeneration++;
+		_pipeline->setRasterizer(_rasterizer);
+		_phasePointsValid = true;
+	}
+
+	_pipeline->request(leftEyePosition, rightEyePosition, invertedBarrier, _phaseCount, _pipelineGeneration);
+
+	_modelTime = 0;
+	_rasterizationTime = 0;
+	if (!_pipeline->acquire(_pipelineGeneration))
+		return;
+
+	const ParallaxBarrierPhaseMaps &phaseMaps = _pipeline->getPhaseMaps();
+	_modelTime = phaseMaps.modelTime;
+	_rasterizationTime = phaseMaps.rasterizationTime;
+	_pipelineErrorRatio = phaseMaps.errorRatio;
 
-	modelRotation.makeRotationMatrix(_viewDirection, ofVec3f(0,0,1));
-	modelUpRotation.makeRotationMatrix(modelRotation*_upDirection, ofVec3f(0,1,0));
-	modelTranslation.makeTranslationMatrix(ofVec3f(_width * 0.5,0,0));
-	modelCenterTranslation.makeTranslationMatrix(-_position);
+	_modelFailuresMetric->increment(phaseMaps.modelFailures);
+	_iterationLimitMetric->increment(phaseMaps.iterationLimits);
+	_guardPixelsMetric->increment(phaseMaps.guardPixels);
+	for (int phase = 0; phase < phaseMaps.phaseCount; phase++)
+	{
+		_boundariesMetric->observe(phaseMaps.boundaries[phase]);
+	}
 
-	_modelTransformation = modelCenterTranslation * modelRotation * modelUpRotation * modelTranslation * modelScale;
+	copy(phaseMaps.screenPoints.begin(), phaseMaps.screenPoints.end(), _phaseScreenPoints);
+	copy(phaseMaps.barrierPoints.begin(), phaseMaps.barrierPoints.end(), _phaseBarrierPoints);
 }
 
-void ParallaxBarrier::updatePixels(bool invertedBarrier)
+void ParallaxBarrier::copyPoints()
 {
-	updateBarrierPixels(invertedBarrier);
-	updateScreenPixels(invertedBarrier);
+	int screenWidth = _rasterizer.getScreenResolutionWidth();
+	int barrierWidth = _rasterizer.getBarrierResolutionWidth();
+
+	//kernel buffers are bound to these arrays
+	copy(_phaseScreenPoints + _phase * screenWidth, _phaseScreenPoints + (_phase + 1) * screenWidth, _screenPoints);
+	copy(_phaseBarrierPoints + _phase * barrierWidth, _phaseBarrierPoints + (_phase + 1) * barrierWidth, _barrierPoints);
 }
 
-void ParallaxBarrier::updateBarrierPixels(bool invertedBarrier)
+int ParallaxBarrier::getPhaseCount()
 {
-	// points in the list are ordered pairs where 
-	// the first point indicates the start of a non-transparent pixel zone, and 
-	// the second point indicates the end of a non-transparent pixel zone
-	const vector<float>& points = _model.getBarrierPoints();
-
-	//initialize points array
-	fill_n(_barrierPoints, _barrierResolutionWidth, invertedBarrier? 1 : 0);
+	return _phaseCount;
+}
 
-	float itValue, floatingPixel, pixelPercentage;
-	int actualPixel, startPixel = 0, endPixel;
-	bool pair = true;
-	for (vector<float>::const_iterator it = points.begin(), end = points.end(); it != end; ++it)
-	{
-		itValue = (*it)*_spacing;
-		floatingPixel = itValue*_barrierInversePixelWidth;
-		actualPixel = floor(floatingPixel);
-		pixelPercentage = floatingPixel - floor(floatingPixel);
+void ParallaxBarrier::setPhaseCount(int phaseCount)
+{
+	_phaseCount = max(phaseCount, 1);
+	_phase = _phase % _phaseCount;
+
+	delete[] _phaseScreenPoints;
+	delete[] _phaseBarrierPoints;
+	_phaseScreenPoints = new cl_char[_phaseCount * _rasterizer.getScreenResolutionWidth()];
+	_phaseBarrierPoints = new cl_char[_phaseCount * _rasterizer.getBarrierResolutionWidth()];
+	fill_n(_phaseScreenPoints, _phaseCount * _rasterizer.getScreenResolutionWidth(), 0);
+	fill_n(_phaseBarrierPoints, _phaseCount * _rasterizer.getBarrierResolutionWidth(), 0);
+	_phasePointsValid = false;
+}
 
-		if (pair && pixelPercentage <= BARRIER_PIXEL_EPSILON_PERCENTAGE)
-		{
-			//previous pixel ends white 
-			endPixel = actualPixel - 1;
+int ParallaxBarrier::getPhase()
+{
+	return _phase;
+}
 
-			//paint white
-			fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? 0: 1);
+void ParallaxBarrier::setPhase(int phase)
+{
+	_phase = phase % _phaseCount;
+	copyPoints();
+}
 
-			//actual pixel starts black
-			startPixel = actualPixel;
-		} else if (pair && pixelPercentage > BARRIER_PIXEL_EPSILON_PERCENTAGE)
-		{
-			//actual pixel ends white
-			endPixel = actualPixel;
+bool ParallaxBarrier::isSubpixel()
+{
+	return (_flags & PARALLAX_BARRIER_SUBPIXEL) != 0;
+}
 
-			//paint white
-			fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? 0: 1);
+int ParallaxBarrier::getSubpixelCount()
+{
+	return getFlagSubpixelCount(_flags);
+}
 
-			//next pixel starts black
-			startPixel = actualPixel + 1;
-		} else if (!pair && pixelPercentage < BARRIER_PIXEL_EPSILON_PERCENTAGE)
-		{
-			//previous pixel ends black
-			endPixel = actualPixel - 1;
+bool ParallaxBarrier::isDamageTracking()
+{
+	return _damageTracking;
+}
 
-			//paint black
-			//paintVerticalPixels(ofColor::black, startPixel, endPixel, _barrierImage);
+void ParallaxBarrier::setDamageTracking(bool damageTracking)
+{
+	_damageTracking = damageTracking;
+	_compositedPointsValid = false;
+	_damagedRegions.clear();
+}
 
-			//actual pixel starts white
-			startPixel = actualPixel;
-		} else if (!pair && pixelPercentage >= BARRIER_PIXEL_EPSILON_PERCENTAGE)
-		{
-			//actual pixel ends black
-			endPixel = actualPixel;
+void ParallaxBarrier::addDamagedRegion(const ofRectangle &region)
+{
+	if (_damageTracking)
+		_damagedRegions.push_back(region);
+}
 
-			//paint black
-			//paintVerticalPixels(ofColor::black, startPixel, endPixel, _barrierImage);
+bool ParallaxBarrier::isPipelined()
+{
+	return _pipeline != NULL;
+}
 
-			//next pixel starts white
-			startPixel = actualPixel + 1;
-		}
+void ParallaxBarrier::setPipelined(bool pipelined)
+{
+	if (pipelined == (_pipeline != NULL))
+		return;
 
-		pair = !pair;
+	if (pipelined)
+	{
+		_pipeline = new ParallaxBarrierPipeline(_rasterizer);
+		_pipeline->start();
 	}
-
-	if (startPixel < _barrierImage.width)
+	else
 	{
-		//actual pixel ends white
-		endPixel = _barrierImage.width - 1;
-
-		//paint white
-		fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? 0: 1);
+		_pipeline->stop();
+		delete _pipeline;
+		_pipeline = NULL;
 	}
 
-	//update screen textures in opencl
-	_barrierKernel->execute(2, _barrierKernelGlobalSize, _barrierKernelLocalSize);
+	//phase maps are recomputed by the new update path
+	_phasePointsValid = false;
 }
 
-void ParallaxBarrier::updateScreenPixels(bool invertedBarrier)
+void ParallaxBarrier::updateImages()
 {
-	//points in the list delimit pixel zones for each eye view
-	//first zone corresponds to left eye view
-	const vector<float>& points = _model.getScreenPoints();
+	unsigned long long startTime = ofGetElapsedTimeMicros();
 
-	// update points
-	//initialize points array
-	fill_n(_screenPoints, _screenResolutionWidth, invertedBarrier? 1: -1);
-
-	float itValue, floatingPixel, pixelPercentage;
-	int actualPixel, startPixel = -1, endPixel;
-	bool pair = true;
-	for (vector<float>::const_iterator it = points.begin(), end = points.end(); it != end; ++it)
+	if (isShaderCompositor())
 	{
-		itValue = (*it)*_spacing;
-		floatingPixel = itValue*_screenInversePixelWidth;
-		actualPixel = floor(floatingPixel);
-		pixelPercentage = floatingPixel - floor(floatingPixel);
-
-		if (startPixel != -1) 
+		//only the column maps are uploaded, views are selected when drawing
+		glBindTexture(GL_TEXTURE_2D, _screenPointsTexture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _rasterizer.getScreenResolutionWidth(), 1, GL_RED_INTEGER, GL_BYTE, _screenPoints);
+		glBindTexture(GL_TEXTURE_2D, _barrierPointsTexture);
+		if (_packedBarrierPoints != NULL)
 		{
-			if (pixelPercentage >= SCREEN_PIXEL_EPSILON_PERCENTAGE && pixelPercentage <= (1 - SCREEN_PIXEL_EPSILON_PERCENTAGE)) 
+			fill_n(_packedBarrierPoints, _packedBarrierWidth, 0);
+			for (int i = 0; i < _rasterizer.getBarrierResolutionWidth(); i++)
 			{
-				//previous pixel ends left/right view
-				endPixel = actualPixel - 1;
-
-				//paint left/right view
-				if (pair)
-				{
-					//paint right view
-					fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? -1: 1);
-				} else
-				{
-					//paint left view
-					//paintVerticalPixels(leftEyeView, startPixel, endPixel, _screenImage);
-				}
-
-				//paint one black pixel
-				fill_n(&_screenPoints[actualPixel], 1, 0);
-
-				//next pixel starts left/right view
-				startPixel = actualPixel + 1;
-
-				errorRatio++;
-			} else if (pair && pixelPercentage < SCREEN_PIXEL_EPSILON_PERCENTAGE)
-			{
-				//previous pixel ends right view
-				endPixel = actualPixel - 1;
+				if (_barrierPoints[i] == 1)
+					_packedBarrierPoints[i >> 3] |= 1 << (i & 7);
+			}
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _packedBarrierWidth, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, _packedBarrierPoints);
+		}
+		else
+		{
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _rasterizer.getBarrierResolutionWidth(), 1, GL_RED_INTEGER, GL_BYTE, _barrierPoints);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	else
+	{
+		//update barrier and screen textures in opencl, only damaged regions and changed columns with damage tracking
+		bool barrierExecuted = executeKernel(_barrierKernel, _barrierKernelGlobalSize, _barrierKernelLocalSize, _barrierPoints, _compositedBarrierPoints, _rasterizer.getBarrierResolutionWidth(), false);
+		bool screenExecuted = executeKernel(_screenKernel, _screenKernelGlobalSize, _screenKernelLocalSize, _screenPoints, _compositedScreenPoints, _rasterizer.getScreenResolutionWidth(), true);
+		if (!barrierExecuted)
+			_kernelErrorsMetric->increment();
+		if (!screenExecuted)
+			_kernelErrorsMetric->increment();
+		//the composited maps were already replaced, after a failed launch the next update is a full one
+		_compositedPointsValid = _damageTracking && barrierExecuted && screenExecuted;
+		_damagedRegions.clear();
+	}
 
-				//paint right view
-				fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? -1: 1);
+	_kernelTime = ofGetElapsedTimeMicros() - startTime;
+}
 
-				//actual pixel starts left view
-				startPixel = actualPixel;
+// range aligned to the work group size and clipped to the global size
+static void addRange(vector<size_t> &offsets, vector<size_t> &sizes, const size_t* globalSize, const size_t* localSize, int x0, int y0, int x1, int y1)
+{
+	x0 = max(0, x0) / (int) localSize[0] * (int) localSize[0];
+	y0 = max(0, y0) / (int) localSize[1] * (int) localSize[1];
+	x1 = min((int) globalSize[0], (x1 + (int) localSize[0] - 1) / (int) localSize[0] * (int) localSize[0]);
+	y1 = min((int) globalSize[1], (y1 + (int) localSize[1] - 1) / (int) localSize[1] * (int) localSize[1]);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	offsets.push_back(x0);
+	offsets.push_back(y0);
+	sizes.push_back(x1 - x0);
+	sizes.push_back(y1 - y0);
+}
 
-			} else if (!pair && pixelPercentage < SCREEN_PIXEL_EPSILON_PERCENTAGE)
-			{
-				//previous pixel ends left view
-				endPixel = actualPixel - 1;
+bool ParallaxBarrier::executeKernel(OpenCLKernel *kernel, const size_t* globalSize, const size_t* localSize, const cl_char* points, cl_char* compositedPoints, int width, bool readsViews)
+{
+	if (!_damageTracking || !_compositedPointsValid)
+	{
+		if (_damageTracking)
+			copy(points, points + width, compositedPoints);
+		if (readsViews)
+			_compositedPixelsMetric->increment(_screenResolutionWidth * _screenResolutionHeight);
+		return kernel->execute(2, globalSize, localSize) && kernel->getStatus() == CL_SUCCESS;
+	}
 
-				//paint left view
-				//paintVerticalPixels(leftEyeView, startPixel, endPixel, _screenImage);
+	_rangeOffsets.clear();
+	_rangeSizes.clear();
 
-				//actual pixel starts right view
-				startPixel = actualPixel;
-				
-			} else if (pair && pixelPercentage > (1 - SCREEN_PIXEL_EPSILON_PERCENTAGE))
-			{
-				//actual pixel ends right view
-				endPixel = actualPixel;
+	//changed columns over the whole height, one range per run of changed work groups
+	int subpixels = getSubpixelCount();
+	int groupWidth = (int) localSize[0] * subpixels;
+	int runStart = -1;
+	for (int x = 0; x < width + groupWidth; x += groupWidth)
+	{
+		int groupEnd = min(x + groupWidth, width);
+		bool changed = x < width && !equal(points + x, points + groupEnd, compositedPoints + x);
+		if (changed && runStart < 0)
+		{
+			runStart = x;
+		}
+		else if (!changed && runStart >= 0)
+		{
+			addRange(_rangeOffsets, _rangeSizes, globalSize, localSize, runStart / subpixels, 0, x / subpixels, (int) globalSize[1]);
+			runStart = -1;
+		}
+	}
+	copy(points, points + width, compositedPoints);
+
+	//damaged regions, widened by the resampling filter of reduced width views
+	if (readsViews)
+	{
+		int filterMargin = (int) ceil(1.f / _eyeResolutionScale);
+		for (vector<ofRectangle>::const_iterator it = _damagedRegions.begin(), end = _damagedRegions.end(); it != end; ++it)
+		{
+			addRange(_rangeOffsets, _rangeSizes, globalSize, localSize, (int) floor(it->x) - filterMargin, (int) floor(it->y), (int) ceil(it->x + it->width) + filterMargin, (int) ceil(it->y + it->height));
+		}
+	}
 
-				//paint right view
-				fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? -1: 1);
+	//ranges may overlap (pixels are written twice with the same value), many or large ranges are a full update
+	size_t rangeCount = _rangeSizes.size() / 2;
+	size_t rangePixels = 0;
+	for (size_t range = 0; range < rangeCount; range++)
+	{
+		rangePixels += _rangeSizes[2 * range] * _rangeSizes[2 * range + 1];
+	}
+
+	if (rangeCount > PARALLAX_BARRIER_MAX_DAMAGE_RANGES || rangePixels * 2 > globalSize[0] * globalSize[1])
+	{
+		if (readsViews)
+			_compositedPixelsMetric->increment(_screenResolutionWidth * _screenResolutionHeight);
+		return kernel->execute(2, globalSize, localSize) && kernel->getStatus() == CL_SUCCESS;
+	}
 
-				//next pixel starts left view
-				startPixel = actualPixel + 1;
+	if (rangeCount == 0)
+		return true;
 
-			} else if (!pair && pixelPercentage > (1 - SCREEN_PIXEL_EPSILON_PERCENTAGE))
-			{
-				//actual pixel ends left view
-				endPixel = actualPixel;
+	if (readsViews)
+		_compositedPixelsMetric->increment(rangePixels);
+	return kernel->execute(2, &_rangeSizes[0], localSize, (int) rangeCount, &_rangeOffsets[0]) && kernel->getStatus() == CL_SUCCESS;
+}
 
-				//paint left view
-				//paintVerticalPixels(leftEyeView, startPixel, endPixel, _screenImage);
+// quad with the target pixel coordinates as texture coordinates
+static void drawCompositorQuad(float x, float y, float width, float height)
+{
+	glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex2f(x, y);
+		glTexCoord2f(width, 0);
+		glVertex2f(x + width, y);
+		glTexCoord2f(width, height);
+		glVertex2f(x + width, y + height);
+		glTexCoord2f(0, height);
+		glVertex2f(x, y + height);
+	glEnd();
+}
 
-				//next pixel starts right view
-				startPixel = actualPixel + 1;
+void ParallaxBarrier::drawScreen(float x, float y)
+{
+	if (!isShaderCompositor())
+	{
+		_screenTexture.draw(x, y);
+		return;
+	}
 
-			}
-		} else 
-		{
-			startPixel = actualPixel;
-		}
+	_screenCompositor->begin();
+	_screenCompositor->setUniform2f("screenSize", _screenResolutionWidth, _screenResolutionHeight);
+	_screenCompositor->setUniform1f("eyeWidth", _eyeResolutionWidth);
 
-		pair = !pair;
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, _screenPointsTexture);
+	_screenCompositor->setUniform1i("screenPoints", 2);
+	if (isLayeredStereo())
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _screenStereoTexture);
+		_screenCompositor->setUniform1i("stereoImage", 0);
+	}
+	else
+	{
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(_screenRightTexture.getTextureData().textureTarget, _screenRightTexture.getTextureData().textureID);
+		_screenCompositor->setUniform1i("rightImage", 1);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(_screenLeftTexture.getTextureData().textureTarget, _screenLeftTexture.getTextureData().textureID);
+		_screenCompositor->setUniform1i("leftImage", 0);
 	}
 
-	// end update points
+	drawCompositorQuad(x, y, _screenResolutionWidth, _screenResolutionHeight);
+
+	//unbind in reverse order, leaving unit 0 active
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (isLayeredStereo())
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	else
+	{
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(_screenRightTexture.getTextureData().textureTarget, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(_screenLeftTexture.getTextureData().textureTarget, 0);
+	}
 
-	//update screen textures in opencl
-	_screenKernel->execute(2, _screenKernelGlobalSize, _screenKernelLocalSize);
+	_screenCompositor->end();
 }
 
 float ParallaxBarrier::getWidth()
 {
-	return _width;
+	return _rasterizer.getWidth();
 }
 
 float ParallaxBarrier::getHeight()
@@ -328,16 +718,35 @@ int ParallaxBarrier::getScreenResolutionHeight()
 	return _screenResolutionHeight;
 }
 
+float ParallaxBarrier::getEyeResolutionScale()
+{
+	return _eyeResolutionScale;
+}
+
+int ParallaxBarrier::getEyeResolutionWidth()
+{
+	return _eyeResolutionWidth;
+}
+
+int ParallaxBarrier::getScreenFormat()
+{
+	return _screenFormat;
+}
+
+int ParallaxBarrier::getBarrierFormat()
+{
+	return _barrierFormat;
+}
+
 float ParallaxBarrier::getSpacing()
 {
-	return _spacing;
+	return _rasterizer.getSpacing();
 }
 
 void ParallaxBarrier::setWidth(float width)
 {
-	this->_width = width;
-	_model.setWidth(_width*_modelScale);
-	updateModelTransformation();
+	_rasterizer.setWidth(width);
+	_phasePointsValid = false;
 }
 
 void ParallaxBarrier::setHeight(float height)
@@ -367,43 +776,141 @@ void ParallaxBarrier::setScreenResolutionHeight(int screenResolutionHeight)
 
 void ParallaxBarrier::setSpacing(float spacing)
 {
-	this->_spacing = spacing;
-	_modelScale = 1.f / _spacing;
-	_model.setWidth(_width*_modelScale);
-	updateModelTransformation();
+	_rasterizer.setSpacing(spacing);
+	_phasePointsValid = false;
 }
 
 const ofVec3f& ParallaxBarrier::getPosition()
 {
-	return _position;
+	return _rasterizer.getPosition();
 }
 
 const ofVec3f& ParallaxBarrier::getViewDirection()
 {
-	return _viewDirection;
+	return _rasterizer.getViewDirection();
 }
 
 const ofVec3f& ParallaxBarrier::getUpDirection()
 {
-	return _upDirection;
+	return _rasterizer.getUpDirection();
 }
 
 void ParallaxBarrier::setPosition(ofVec3f position)
 {
-	this->_position = position;
-	updateModelTransformation();
+	_rasterizer.setPosition(position);
+	_phasePointsValid = false;
 }
 
 void ParallaxBarrier::setViewDirection(ofVec3f viewDirection)
 {
-	this->_viewDirection = viewDirection;
-	updateModelTransformation();
+	_rasterizer.setViewDirection(viewDirection);
+	_phasePointsValid = false;
 }
 
 void ParallaxBarrier::setUpDirection(ofVec3f upDirection)
 {
-	this->_upDirection = upDirection;
-	updateModelTransformation();
+	_rasterizer.setUpDirection(upDirection);
+	_phasePointsValid = false;
+}
+
+int ParallaxBarrier::getErrorRatio()
+{
+	return _pipeline != NULL? _pipelineErrorRatio : _rasterizer.getErrorRatio();
+}
+
+unsigned long long ParallaxBarrier::getModelTime()
+{
+	return _modelTime;
+}
+
+unsigned long long ParallaxBarrier::getRasterizationTime()
+{
+	return _rasterizationTime;
+}
+
+unsigned long long ParallaxBarrier::getKernelTime()
+{
+	return _kernelTime;
+}
+
+ParallaxBarrierRasterizer& ParallaxBarrier::getRasterizer()
+{
+	return _rasterizer;
+}
+
+const cl_char* ParallaxBarrier::getScreenPoints()
+{
+	return _screenPoints;
+}
+
+const cl_char* ParallaxBarrier::getBarrierPoints()
+{
+	return _barrierPoints;
+}
+
+ofTexture& ParallaxBarrier::getScreenTexture()
+{
+	return _screenTexture;
+}
+
+ofTexture& ParallaxBarrier::getBarrierTexture()
+{
+	return _barrierTexture;
+}
+
+ofTexture& ParallaxBarrier::getScreenLeftTexture()
+{
+	return _screenLeftTexture;
+}
+
+ofTexture& ParallaxBarrier::getScreenRightTexture()
+{
+	return _screenRightTexture;
+}
+
+bool ParallaxBarrier::isSingleRowBarrier()
+{
+	return (_flags & PARALLAX_BARRIER_SINGLE_ROW_BARRIER) != 0;
+}
+
+void ParallaxBarrier::drawBarrier(float x, float y)
+{
+	if (!isShaderCompositor())
+	{
+		_barrierTexture.draw(x, y, _barrierResolutionWidth, _barrierResolutionHeight);
+		return;
+	}
+
+	_barrierCompositor->begin();
+	glBindTexture(GL_TEXTURE_2D, _barrierPointsTexture);
+	_barrierCompositor->setUniform1i("barrierPoints", 0);
+
+	drawCompositorQuad(x, y, _barrierResolutionWidth, _barrierResolutionHeight);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	_barrierCompositor->end();
+}
+
+bool ParallaxBarrier::isShaderCompositor()
+{
+	return (_flags & PARALLAX_BARRIER_SHADER_COMPOSITOR) != 0;
+}
+
+bool ParallaxBarrier::isPixelReadback()
+{
+	return (_flags & PARALLAX_BARRIER_PIXEL_READBACK) != 0;
+}
+
+void ParallaxBarrier::readPixels()
+{
+	if (!isPixelReadback() || isShaderCompositor())
+	{
+		ofLogWarning("ParallaxBarrier") << "readPixels needs PARALLAX_BARRIER_PIXEL_READBACK without PARALLAX_BARRIER_SHADER_COMPOSITOR";
+		return;
+	}
+
+	_screenTexture.readToPixels(_screenImage.getPixelsRef());
+	_barrierTexture.readToPixels(_barrierImage.getPixelsRef());
 }
 
 ofImage& ParallaxBarrier::getScreenImage()
@@ -416,12 +923,13 @@ ofImage& ParallaxBarrier::getBarrierImage()
 	return _barrierImage;
 }
 
-ofImage& ParallaxBarrier::getScreenLeftImage()
+
+bool ParallaxBarrier::isLayeredStereo()
 {
-	return _screenLeftImage;
+	return (_flags & PARALLAX_BARRIER_LAYERED_STEREO) != 0;
 }
 
-ofImage& ParallaxBarrier::getScreenRightImage()
+GLuint ParallaxBarrier::getScreenStereoTexture()
 {
-	return _screenRightImage;
-}
+	return _screenStereoTexture;
+}
\ No newline at end of file
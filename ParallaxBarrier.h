@@ -2,17 +2,55 @@
 
 #include "ofVec3f.h"
 #include "ofImage.h"
+#include "ofTexture.h"
+#include "ofRectangle.h"
 
-#include "ParallaxBarrierModel.h"
+#include "ParallaxBarrierRasterizer.h"
+#include "ParallaxBarrierPipeline.h"
+#include "Metrics.h"
 #include "opencl/OpenCLKernel.h"
+#include "opengl/OpenGLShader.h"
 
-#define SCREEN_PIXEL_EPSILON_PERCENTAGE 0.01f//0.10f
-#define BARRIER_PIXEL_EPSILON_PERCENTAGE 0.01f//0.05f
+// ParallaxBarrier construction flags
+// - PARALLAX_BARRIER_LAYERED_STEREO: left/right views are the two layers of a single 
+//   2D texture array (see getScreenStereoTexture), so both can be rendered in one pass
+// - PARALLAX_BARRIER_PIXEL_READBACK: screen/barrier pixels can be read back to CPU images 
+//   (see readPixels), otherwise targets are textures without CPU pixels
+// - PARALLAX_BARRIER_SINGLE_ROW_BARRIER: the barrier texture is a single row (barrier width x 1, 
+//   nearest filtering) to be stretched to the barrier height when drawn
+// - PARALLAX_BARRIER_SHADER_COMPOSITOR: no OpenCL, column maps are uploaded as textures and 
+//   views are selected by fragment shaders in 'drawScreen'/'drawBarrier' (no screen/barrier textures)
+// - PARALLAX_BARRIER_PIPELINED: column maps are computed on a worker thread (see setPipelined)
+// - PARALLAX_BARRIER_SUBPIXEL: RGB stripe panels, column maps hold one entry per subpixel (3 per pixel,
+//   red first) so each channel of the screen shows its own view and each channel of the barrier 
+//   is transparent or opaque on its own (R8 barriers fall back to RGBA8)
+#define PARALLAX_BARRIER_LAYERED_STEREO 0x01
+#define PARALLAX_BARRIER_PIXEL_READBACK 0x02
+#define PARALLAX_BARRIER_SINGLE_ROW_BARRIER 0x04
+#define PARALLAX_BARRIER_SHADER_COMPOSITOR 0x08
+#define PARALLAX_BARRIER_PIPELINED 0x10
+#define PARALLAX_BARRIER_SUBPIXEL 0x20
+
+// screen target formats (left/right views and screen),
+// RGB formats need the shader compositor, OpenCL images fall back to RGBA8
+#define PARALLAX_BARRIER_SCREEN_RGBA8 0
+#define PARALLAX_BARRIER_SCREEN_RGB8 1
+#define PARALLAX_BARRIER_SCREEN_RGB10 2
+
+// most ranges a damage tracking kernel update is split into, more are merged into a full update
+#define PARALLAX_BARRIER_MAX_DAMAGE_RANGES 32
+
+// barrier target formats
+// - R8: single channel barrier texture, drawn as gray through a texture swizzle
+// - PACKED: one bit per barrier column, needs the shader compositor (falls back to R8)
+#define PARALLAX_BARRIER_BARRIER_RGBA8 0
+#define PARALLAX_BARRIER_BARRIER_R8 1
+#define PARALLAX_BARRIER_BARRIER_PACKED 2
 
 class ParallaxBarrier
 {
 public:
-	ParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection);
+	ParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, int flags = 0, float eyeResolutionScale = 1.f, int screenFormat = PARALLAX_BARRIER_SCREEN_RGBA8, int barrierFormat = PARALLAX_BARRIER_BARRIER_RGBA8);
 	virtual ~ParallaxBarrier();
 
 	float getWidth();
@@ -21,6 +59,13 @@ public:
 	int getScreenResolutionHeight();
 	int getBarrierResolutionWidth();
 	int getBarrierResolutionHeight();
+	// left/right views are rendered at 'eyeResolutionScale' times the screen width
+	// and resampled by the screen kernel
+	float getEyeResolutionScale();
+	int getEyeResolutionWidth();
+	// formats in use, after falling back from unsupported ones
+	int getScreenFormat();
+	int getBarrierFormat();
 	float getSpacing();
 	const ofVec3f& getPosition();
 	const ofVec3f& getViewDirection();
@@ -37,42 +82,129 @@ public:
 	void setUpDirection(ofVec3f upDirection);
 
 	void update(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier = false);
+	// 'update' is equivalent to 'updatePoints' followed by 'updateImages', 
+	// both can be called separately when column maps are needed before the views are drawn
+	void updatePoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier = false);
+	void updateImages();
+
+	// column maps of the last 'updatePoints' call for the selected phase
+	// screen points: -1 left view, 1 right view, 0 black
+	// barrier points: 1 transparent, 0 opaque
+	// the maps have 'getSubpixelCount' entries per pixel
+	const cl_char* getScreenPoints();
+	const cl_char* getBarrierPoints();
+	bool isSubpixel();
+	int getSubpixelCount();
+
+	// time multiplexing: 'updatePoints' computes the column maps of every phase at once, 
+	// phase k shifts the zones by 2k/phaseCount zones (a whole zone shift is a barrier inversion).
+	// 'setPhase' selects the maps used by the kernels without recomputing them, 
+	// maps are only recomputed when eye positions, inversion or geometry change
+	int getPhaseCount();
+	void setPhaseCount(int phaseCount);
+	int getPhase();
+	void setPhase(int phase);
+
+	// damage tracking: 'updateImages' only recomposites the damaged regions of the views and the
+	// columns whose screen/barrier maps changed since the last update, instead of the whole images.
+	// Regions are in screen image pixels (kernel coordinates, first texture row at y 0) and cover
+	// changes of either view, they are cleared by 'updateImages'. Views must not change outside of
+	// the reported regions. Not used by the shader compositor, which draws the whole screen anyway
+	bool isDamageTracking();
+	void setDamageTracking(bool damageTracking);
+	void addDamagedRegion(const ofRectangle &region);
+
+	// pipelined updates: 'updatePoints' hands the eye positions to a worker thread (ParallaxBarrierPipeline)
+	// and uses the newest maps the worker completed, without waiting for them. Model and rasterization
+	// run while the render thread draws, maps lag the eye positions by up to one update.
+	// Only the first update after a geometry or phase count change waits for its maps
+	bool isPipelined();
+	void setPipelined(bool pipelined);
+
+	ofTexture& getScreenTexture();
+	ofTexture& getBarrierTexture();
 
+	ofTexture& getScreenLeftTexture();
+	ofTexture& getScreenRightTexture();
+
+	bool isSingleRowBarrier();
+	bool isShaderCompositor();
+	// draw the screen/barrier of the last 'updateImages' call at their resolution,
+	// single row barriers are stretched to the barrier height
+	void drawScreen(float x, float y);
+	void drawBarrier(float x, float y);
+
+	// CPU copies of the screen/barrier textures, updated by 'readPixels'
+	// only available when created with PARALLAX_BARRIER_PIXEL_READBACK (and no shader compositor)
+	bool isPixelReadback();
+	void readPixels();
 	ofImage& getScreenImage();
 	ofImage& getBarrierImage();
 
-	ofImage& getScreenLeftImage();
-	ofImage& getScreenRightImage();
+	// layered stereo target (layer 0: left view, layer 1: right view)
+	// only available when created with PARALLAX_BARRIER_LAYERED_STEREO
+	bool isLayeredStereo();
+	GLuint getScreenStereoTexture();
 
+	// guard pixels of the last rasterization, totals over time are kept in 
+	// MetricsRegistry (boundaries, guard pixels, model failures, kernel errors)
 	int getErrorRatio();
+	ParallaxBarrierRasterizer& getRasterizer();
+
+	// durations of the last update stages in microseconds,
+	// model/rasterization cover all phases and are 0 when the maps were reused,
+	// when pipelined they are the worker times of newly acquired maps
+	unsigned long long getModelTime();
+	unsigned long long getRasterizationTime();
+	unsigned long long getKernelTime();
 private:
-	float _width;
 	float _height;
 	int _barrierResolutionWidth;
 	int _barrierResolutionHeight;
 	int _screenResolutionWidth;
 	int _screenResolutionHeight;
-	float _spacing;
-	ofVec3f _position;
-	ofVec3f _viewDirection;
-	ofVec3f _upDirection;
-	float _barrierInversePixelWidth;
-	float _screenInversePixelWidth;
+	float _eyeResolutionScale;
+	int _eyeResolutionWidth;
+	int _flags;
+	int _screenFormat;
+	int _barrierFormat;
+
+	unsigned long long _modelTime;
+	unsigned long long _rasterizationTime;
+	unsigned long long _kernelTime;
 
-	int errorRatio;
+	// registry metrics, shared by all instances
+	MetricHistogram* _boundariesMetric;
+	MetricCounter* _guardPixelsMetric;
+	MetricCounter* _modelFailuresMetric;
+	MetricCounter* _iterationLimitMetric;
+	MetricCounter* _kernelErrorsMetric;
+	MetricCounter* _compositedPixelsMetric;
 
-	// model transformation
-	ofMatrix4x4 _modelTransformation;
-	float _modelScale;
-	ofVec2f _modelLeftEyePosition;
-	ofVec2f _modelRightEyePosition;
+	int _phaseCount;
+	int _phase;
+	// column maps of all phases, one after the other
+	cl_char* _phaseScreenPoints;
+	cl_char* _phaseBarrierPoints;
+	bool _phasePointsValid;
+	ofVec3f _phaseLeftEyePosition;
+	ofVec3f _phaseRightEyePosition;
+	bool _phaseInvertedBarrier;
 
-	ParallaxBarrierModel _model;
+	ParallaxBarrierRasterizer _rasterizer;
 
+	ParallaxBarrierPipeline* _pipeline;
+	// incremented for every geometry or phase count change while pipelined
+	unsigned long _pipelineGeneration;
+	int _pipelineErrorRatio;
+
+	ofTexture _barrierTexture;
+	ofTexture _screenTexture;
+	ofTexture _screenLeftTexture;
+	ofTexture _screenRightTexture;
 	ofImage _barrierImage;
 	ofImage _screenImage;
-	ofImage _screenLeftImage;
-	ofImage _screenRightImage;
+	GLuint _screenStereoTexture;
 
 	OpenCLKernel * _screenKernel;
 	OpenCLKernel * _barrierKernel;
@@ -83,7 +215,7 @@ private:
 	size_t _barrierKernelGlobalSize[2];
 
 	OpenCLBuffer *_screenPointsBuffer;
-	OpenCLTexture *_leftImageTexture, *_rightImageTexture, *_screenImageTexture;
+	OpenCLTexture *_leftImageTexture, *_rightImageTexture, *_stereoImageTexture, *_screenImageTexture;
 
 	OpenCLBuffer *_barrierPointsBuffer;
 	OpenCLTexture *_barrierImageTexture;
@@ -95,12 +227,32 @@ private:
 	list<OpenCLBuffer*> _barrierKernelReadBuffers;
 	list<OpenCLTexture*> _barrierKernelWriteTextures;
 
+	// shader compositor, column maps as single row integer textures
+	OpenGLShader *_screenCompositor;
+	OpenGLShader *_barrierCompositor;
+	GLuint _screenPointsTexture;
+	GLuint _barrierPointsTexture;
+	unsigned char* _packedBarrierPoints;
+	int _packedBarrierWidth;
+
 	cl_char* _screenPoints;
 	cl_char* _barrierPoints;
 
-	void updateModelTransformation();
-	void updatePixels(bool invertedBarrier);
-	void updateScreenPixels(bool invertedBarrier);
-	void updateBarrierPixels(bool invertedBarrier);
+	bool _damageTracking;
+	vector<ofRectangle> _damagedRegions;
+	// maps of the last kernel update, changed columns are recomposited
+	cl_char* _compositedScreenPoints;
+	cl_char* _compositedBarrierPoints;
+	bool _compositedPointsValid;
+	// kernel ranges, two values (x, y) per range
+	vector<size_t> _rangeOffsets;
+	vector<size_t> _rangeSizes;
+
+	void updatePhasePoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier);
+	void updatePipelinedPoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier);
+	void copyPoints();
+	bool executeKernel(OpenCLKernel *kernel, const size_t* globalSize, const size_t* localSize, const cl_char* points, cl_char* compositedPoints, int width, bool readsViews);
+	void initializeKernels();
+	void initializeCompositor();
 };
 
@@ -1,7 +1,8 @@
 #include "ParallaxBarrierApp.h"
 
+static const unsigned long long stageBuckets[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 16667, 25000, 50000, 100000 };
 
-BarrierWindow::BarrierWindow(): barrierImage(NULL)
+BarrierWindow::BarrierWindow(): parallaxBarrier(NULL), verticalSyncApplied(false)
 {
 }
 
@@ -10,19 +11,23 @@ BarrierWindow::~BarrierWindow()
 {
 }
 
-//--------------------------------------------------------------
-void BarrierWindow::setup()
-{
-}
-
 //--------------------------------------------------------------
 void BarrierWindow::draw()
 {
-	//draw barrier texture
-	if (barrierImage != NULL && parallaxBarrierApp->updateBarrier)
+	//barrier presents right after the screen window, only the screen window waits for vblank.
+	//Applied while drawing, when this window's context is the current one
+	if (!verticalSyncApplied)
+	{
+		ofSetVerticalSync(false);
+		verticalSyncApplied = true;
+	}
+
+	//draw barrier texture of the last composited frame, redrawn while no new frame is available
+	if (parallaxBarrier != NULL)
 	{
-		barrierImage->draw(0,0);
-		parallaxBarrierApp->updateBarrier = false;
+		FramePacer& framePacer = parallaxBarrierApp->getFramePacer();
+		parallaxBarrier->drawBarrier(0,0);
+		framePacer.presentBarrier(framePacer.getCompositedFrame());
 	}
 }
 
@@ -33,13 +38,29 @@ void BarrierWindow::keyReleased(int key, ofxFenster* window)
 		window->toggleFullscreen();
 }
 
-ParallaxBarrierApp::ParallaxBarrierApp(): parallaxBarrier(NULL)
+ParallaxBarrierApp::ParallaxBarrierApp(): eyeSampleTime(0), maskColumns(false), eyeTracker(NULL), frameSource(NULL), barrierSink(NULL), showTimings(false), metricsInterval(10.f), eyeTraceReplayRealtime(true), captureContent(FRAME_CAPTURE_PIXELS), parallaxBarrier(NULL), stereoShader(NULL), eyeTraceReplayRecord(0), eyeTraceReplayStartTime(0), screenVerticalSync(-1)
 {
+	MetricsRegistry &metrics = MetricsRegistry::get();
+	for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+	{
+		stageMetrics[stage] = &metrics.histogram("parallax_barrier_stage_duration_microseconds", "Duration of the frame stages", stageBuckets, sizeof(stageBuckets) / sizeof(stageBuckets[0]), string("stage=\"") + FrameTimings::getStageName(stage) + "\"");
+	}
+	framesMetric = &metrics.counter("parallax_barrier_frames_total", "Composited frames");
+	skippedFramesMetric = &metrics.counter("parallax_barrier_skipped_frames_total", "Screen frames repeating the last composited frame while the barrier window was pending");
 }
 
 ParallaxBarrierApp::~ParallaxBarrierApp()
 {
+	if (eyeTracker != NULL)
+	{
+		eyeTracker->stop();
+		delete eyeTracker;
+	}
+	delete frameSource;
+	delete barrierSink;
+	frameCapture.close();
 	delete parallaxBarrier;
+	delete stereoShader;
 }
 
 //--------------------------------------------------------------
@@ -48,7 +69,45 @@ void ParallaxBarrierApp::setup()
 	//ParallaxBarrier app setup
 	setupApp();
 
-	if (parallaxBarrier != NULL)
+	if (parallaxBarrier != NULL && parallaxBarrier->isLayeredStereo())
+	{
+		// layered depth texture, one layer per eye
+		glGenTextures(1, &frameBufferDepthTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, frameBufferDepthTexture);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, parallaxBarrier->getEyeResolutionWidth(), parallaxBarrier->getScreenResolutionHeight(), 2, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		// layered attachments, the layer of each primitive is selected by the stereo shader
+		glGenFramebuffers(1, &frameBufferObject);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
+
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, frameBufferDepthTexture, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, parallaxBarrier->getScreenStereoTexture(), 0);
+	}
+	else if (parallaxBarrier != NULL && maskColumns)
+	{
+		// depth/stencil texture, stencil holds the column mask of each view
+		glGenTextures(1, &frameBufferDepthTexture);
+		glBindTexture(GL_TEXTURE_2D, frameBufferDepthTexture);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, parallaxBarrier->getEyeResolutionWidth(), parallaxBarrier->getScreenResolutionHeight(), 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &frameBufferObject);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, frameBufferDepthTexture, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, parallaxBarrier->getScreenLeftTexture().getTextureData().textureID, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, parallaxBarrier->getScreenRightTexture().getTextureData().textureID, 0);
+	}
+	else if (parallaxBarrier != NULL)
 	{
 		glGenTextures(1, &frameBufferDepthTexture);
 		glBindTexture(GL_TEXTURE_2D, frameBufferDepthTexture);
@@ -56,7 +115,7 @@ void ParallaxBarrierApp::setup()
 			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, parallaxBarrier->getScreenResolutionWidth(), parallaxBarrier->getScreenResolutionHeight(), 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, parallaxBarrier->getEyeResolutionWidth(), parallaxBarrier->getScreenResolutionHeight(), 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
 		// The framebuffer, which regroups 0, 1, or more textures, and 0 or 1 depth buffer.
@@ -64,8 +123,8 @@ void ParallaxBarrierApp::setup()
 		glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
 
 		glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, frameBufferDepthTexture, 0);
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, parallaxBarrier->getScreenLeftImage().getTextureReference().getTextureData().textureID, 0);
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, parallaxBarrier->getScreenRightImage().getTextureReference().getTextureData().textureID, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, parallaxBarrier->getScreenLeftTexture().getTextureData().textureID, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, parallaxBarrier->getScreenRightTexture().getTextureData().textureID, 0);
 	}
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -88,73 +147,155 @@ void ParallaxBarrierApp::setup()
 
 	barrierWindowListener->parallaxBarrierApp = this;
 
-	if (parallaxBarrier != NULL)
-	{
-		barrierWindowListener->barrierImage = &(parallaxBarrier->getBarrierImage());
-	}		
+	barrierWindowListener->parallaxBarrier = parallaxBarrier;
 
 	invertBarrier = false;
-	invertCounter = 0;
-	invertLimit = 0;
-	updateBarrier = false;
+
+	maskColumns = maskColumns && parallaxBarrier != NULL && !parallaxBarrier->isLayeredStereo() && frameSource == NULL;
+
+	if (eyeTracker != NULL)
+	{
+		eyeTracker->start();
+	}
+
+	if (barrierSink != NULL && !barrierSink->start())
+		ofLogWarning("ParallaxBarrierApp") << "could not start the barrier sink";
+
+	//metrics files are written by their own thread, not in the frame
+	if (!metricsFileName.empty())
+		metricsWriter.start(metricsFileName, metricsInterval);
+
+	if (!eyeTraceFileName.empty() && !eyeTraceWriter.open(eyeTraceFileName))
+		ofLogWarning("ParallaxBarrierApp") << "could not record eye trace to " << eyeTraceFileName;
+
+	if (!captureFileName.empty() && (parallaxBarrier == NULL || !frameCapture.open(captureFileName, *parallaxBarrier, captureContent)))
+		ofLogWarning("ParallaxBarrierApp") << "could not capture frames to " << captureFileName;
+
+	if (!eyeTraceReplayFileName.empty())
+	{
+		if (!eyeTraceReplay.open(eyeTraceReplayFileName) || eyeTraceReplay.getRecordCount() == 0)
+		{
+			ofLogWarning("ParallaxBarrierApp") << "could not replay eye trace " << eyeTraceReplayFileName;
+			eyeTraceReplay.close();
+		}
+		eyeTraceReplayStartTime = ofGetElapsedTimeMicros();
+	}
 }
 
 //--------------------------------------------------------------
-void ParallaxBarrierApp::initializeParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, int screenOffsetX, int screenOffsetY)
+void ParallaxBarrierApp::initializeParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, int screenOffsetX, int screenOffsetY, int flags, float eyeResolutionScale, int screenFormat, int barrierFormat)
 {
 	this->screenOffsetX = screenOffsetX;
 	this->screenOffsetY = screenOffsetY;
-	parallaxBarrier = new ParallaxBarrier(width, height, screenResolutionWidth, screenResolutionHeight, barrierResolutionWidth, barrierResolutionHeight, spacing, position, viewDirection, upDirection);
+
+	//the layered target is only usable with the stereo shader, otherwise the views are drawn in two passes
+	if ((flags & PARALLAX_BARRIER_LAYERED_STEREO) != 0)
+	{
+		stereoShader = new OpenGLShader("opengl/shader/stereo.vert", "opengl/shader/stereo.frag", "opengl/shader/stereo.geom");
+		if (!stereoShader->getStatus())
+		{
+			ofLogError("ParallaxBarrierApp") << "stereo shader unavailable, falling back to two pass rendering";
+			delete stereoShader;
+			stereoShader = NULL;
+			flags &= ~PARALLAX_BARRIER_LAYERED_STEREO;
+		}
+	}
+
+	parallaxBarrier = new ParallaxBarrier(width, height, screenResolutionWidth, screenResolutionHeight, barrierResolutionWidth, barrierResolutionHeight, spacing, position, viewDirection, upDirection, flags, eyeResolutionScale, screenFormat, barrierFormat);
 
 	viewport = ofRectangle(screenOffsetX, screenOffsetY, screenResolutionWidth, screenResolutionHeight);
+	eyeViewport = ofRectangle(0, 0, parallaxBarrier->getEyeResolutionWidth(), screenResolutionHeight);
 }
 
 //--------------------------------------------------------------
 void ParallaxBarrierApp::draw()
 {
-	if (parallaxBarrier != NULL && !updateBarrier)
+	FrameTiming frameTiming;
+	bool frameComposited = false;
+
+	//vertical sync only applies to the current context, the screen window's while it draws
+	if (screenVerticalSync != (int) framePacer.getVerticalSync())
 	{
-		//draw left image and load into left texture
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
-		glDrawBuffer(GL_COLOR_ATTACHMENT0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		ofSetVerticalSync(framePacer.getVerticalSync());
+		screenVerticalSync = framePacer.getVerticalSync();
+	}
 
-		ofPushMatrix();
-		if (ofGetWindowHeight() > parallaxBarrier->getScreenResolutionHeight())
+	//a new frame is only composited once the barrier window presented the previous one
+	if (parallaxBarrier != NULL && !framePacer.isBarrierPending())
+	{
+		frameTiming.frameId = framePacer.beginFrame();
+
+		//newest tracker sample, never waits for the tracker
+		EyeTrackerSample eyeTrackerSample;
+		if (eyeTracker != NULL && eyeTracker->getLatestSample(eyeTrackerSample))
 		{
-			ofTranslate(0, ofGetWindowHeight() - parallaxBarrier->getScreenResolutionHeight());
+			leftEyePosition = eyeTrackerSample.leftEyePosition;
+			rightEyePosition = eyeTrackerSample.rightEyePosition;
+			eyeSampleTime = eyeTrackerSample.time;
 		}
-		
-		ofPushView();
-		drawLeft();
-		ofPopView();
 
-		//draw right image and load into right texture
-		glDrawBuffer(GL_COLOR_ATTACHMENT1);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (eyeTraceReplay.isOpen())
+		{
+			replayEyeTrace();
+		}
 
-		ofPushView();
-		drawRight();
-		ofPopView();
+		frameTiming.frameTime = ofGetElapsedTimeMicros();
 
-		ofPopMatrix();
+		//phases advance once per frame both windows show (screen presents repeating a frame while 
+		//the barrier is pending do not count), maps of every phase are computed once per eye update
+		parallaxBarrier->setPhase(frameTiming.frameId % parallaxBarrier->getPhaseCount());
 
-		//disable fbo and use screen
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		frameTiming.stages[FRAME_TIMING_EYE_SAMPLE_AGE] = eyeSampleTime != 0 && eyeSampleTime < frameTiming.frameTime? frameTiming.frameTime - eyeSampleTime : 0;
+		frameComposited = true;
 
-		ofSetColor(ofColor::white);
+		if (frameSource != NULL)
+		{
+			//a new clip frame replaces the whole views, damage is in screen pixels (not view pixels)
+			if (frameSource->update(*parallaxBarrier) && parallaxBarrier->isDamageTracking())
+				addDamagedRegion(ofRectangle(0, 0, viewport.width, viewport.height));
+		}
+		else
+		{
+			drawViews();
+		}
+
+		frameTiming.stages[FRAME_TIMING_SCENE] = ofGetElapsedTimeMicros() - frameTiming.frameTime;
 
 		//update parallax barrier
-		parallaxBarrier->update(leftEyePosition, rightEyePosition, invertBarrier);
+		if (maskColumns)
+		{
+			parallaxBarrier->updateImages();
+		}
+		else
+		{
+			parallaxBarrier->update(leftEyePosition, rightEyePosition, invertBarrier);
+		}
+
+		frameTiming.stages[FRAME_TIMING_MODEL] = parallaxBarrier->getModelTime();
+		frameTiming.stages[FRAME_TIMING_RASTERIZATION] = parallaxBarrier->getRasterizationTime();
+		frameTiming.stages[FRAME_TIMING_KERNEL] = parallaxBarrier->getKernelTime();
+		if (maskColumns && !parallaxBarrier->isPipelined())
+		{
+			//column maps were computed between the scene passes
+			frameTiming.stages[FRAME_TIMING_SCENE] -= frameTiming.stages[FRAME_TIMING_MODEL] + frameTiming.stages[FRAME_TIMING_RASTERIZATION];
+		}
 
-		if (invertLimit > 0 && invertCounter > invertLimit)
+		if (frameCapture.isOpen())
 		{
-			invertCounter = 0;
-			invertBarrier = !invertBarrier;
+			frameCapture.capture(*parallaxBarrier, frameTiming.frameId, frameTiming.frameTime);
 		}
-		invertCounter ++;
 
-		//draw screen texture
+		if (barrierSink != NULL && barrierSink->isStarted())
+		{
+			barrierSink->send(parallaxBarrier->getBarrierPoints(), parallaxBarrier->getBarrierResolutionWidth() * parallaxBarrier->getSubpixelCount());
+		}
+	}
+
+	if (parallaxBarrier != NULL)
+	{
+		ofSetColor(ofColor::white);
+
+		//draw screen texture of the last composited frame
 		ofPushMatrix();
 		ofScale(1,-1);
 		if (ofGetWindowHeight() > parallaxBarrier->getScreenResolutionHeight())
@@ -167,10 +308,23 @@ void ParallaxBarrierApp::draw()
 		}
 
 		ofDisableLighting();
-		parallaxBarrier->getScreenImage().draw(screenOffsetX, -screenOffsetY);
+		parallaxBarrier->drawScreen(screenOffsetX, -screenOffsetY);
 		ofPopMatrix();
 
-		updateBarrier = true;
+		framePacer.presentScreen(framePacer.getCompositedFrame());
+
+		if (frameComposited)
+		{
+			frameTiming.stages[FRAME_TIMING_PRESENT] = ofGetElapsedTimeMicros() - frameTiming.frameTime;
+			frameTimings.push(frameTiming);
+
+			if (eyeTraceWriter.isOpen())
+			{
+				eyeTraceWriter.record(frameTiming.frameTime, leftEyePosition, rightEyePosition, frameTiming);
+			}
+		}
+
+		updateMetrics(frameTiming, frameComposited);
 	}
 
 	ofSetColor(255);
@@ -178,26 +332,291 @@ void ParallaxBarrierApp::draw()
 	msg += "\nfps: " + ofToString(ofGetFrameRate(), 2);
 	msg += "\ns: " + ofToString(parallaxBarrier->getSpacing(), 3);
 	msg += "\nox: " + ofToString(screenOffsetX, 3);
+	msg += "\nphases: " + ofToString(parallaxBarrier->getPhaseCount());
+	if (showTimings)
+	{
+		drawTimings(msg);
+	}
 	ofDrawBitmapStringHighlight(msg, 10, 20);
 
 
 }
 
+//--------------------------------------------------------------
+void ParallaxBarrierApp::updateMetrics(const FrameTiming &frameTiming, bool frameComposited)
+{
+	if (frameComposited)
+	{
+		framesMetric->increment();
+		for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+		{
+			stageMetrics[stage]->observe(frameTiming.stages[stage]);
+		}
+	}
+	else
+	{
+		skippedFramesMetric->increment();
+	}
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::replayEyeTrace()
+{
+	size_t record;
+	if (eyeTraceReplayRealtime)
+	{
+		//newest record at the replay time, restarting one mean record period after the last record
+		unsigned long long duration = eyeTraceReplay.getDuration();
+		unsigned long long cycle = duration + (eyeTraceReplay.getRecordCount() > 1? duration / (eyeTraceReplay.getRecordCount() - 1) : 0);
+		unsigned long long replayTime = ofGetElapsedTimeMicros() - eyeTraceReplayStartTime;
+		if (cycle > 0 && replayTime >= cycle)
+		{
+			eyeTraceReplayStartTime += replayTime - replayTime % cycle;
+			replayTime %= cycle;
+		}
+		record = eyeTraceReplay.findRecord(eyeTraceReplay.getRecord(0).time + replayTime);
+	}
+	else
+	{
+		record = eyeTraceReplayRecord++ % eyeTraceReplay.getRecordCount();
+	}
+
+	const EyeTraceRecord &eyeTraceRecord = eyeTraceReplay.getRecord(record);
+	leftEyePosition = eyeTraceRecord.getLeftEyePosition();
+	rightEyePosition = eyeTraceRecord.getRightEyePosition();
+	//recorded sample ages do not apply to the replay
+	eyeSampleTime = 0;
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::drawColumnMask()
+{
+	// stencil bit 1 marks left view columns, bit 2 marks right view columns, 
+	// black guard columns stay 0 and are not drawn by any view
+	// with subpixel maps columns are subpixels, runs are grown to whole pixels
+	// (pixels showing both views get both bits)
+	const cl_char* screenPoints = parallaxBarrier->getScreenPoints();
+	int subpixels = parallaxBarrier->getSubpixelCount();
+	int width = parallaxBarrier->getScreenResolutionWidth() * subpixels;
+	int height = parallaxBarrier->getScreenResolutionHeight();
+
+	// reduced width targets are resampled by the screen kernel, so runs are grown 
+	// by one eye pixel to keep the filter neighbours drawn (both bits can be set there)
+	float margin = parallaxBarrier->getEyeResolutionWidth() != parallaxBarrier->getScreenResolutionWidth()? width / eyeViewport.width : 0;
+
+	glClear(GL_STENCIL_BUFFER_BIT);
+	glEnable(GL_STENCIL_TEST);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+
+	ofPushView();
+	glViewport(0, 0, eyeViewport.width, eyeViewport.height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0, width, 0, height, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	// one quad per run of columns with the same view
+	int startColumn = 0;
+	for (int i = 1; i <= width; i++)
+	{
+		if (i == width || screenPoints[i] != screenPoints[startColumn])
+		{
+			if (screenPoints[startColumn] != 0)
+			{
+				int bit = screenPoints[startColumn] == -1? 1 : 2;
+				glStencilMask(bit);
+				glStencilFunc(GL_ALWAYS, bit, bit);
+				glRectf(startColumn / subpixels * subpixels - margin, 0, (i + subpixels - 1) / subpixels * subpixels + margin, height);
+			}
+			startColumn = i;
+		}
+	}
+
+	ofPopView();
+
+	glStencilMask(0xFF);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_STENCIL_TEST);
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::drawTimings(string &msg)
+{
+	static const float percentiles[3] = { 0.5f, 0.95f, 0.99f };
+	unsigned long long values[3];
+	vector<FrameTiming> timings;
+
+	frameTimings.snapshot(timings);
+
+	msg += "\n\nms (p50/p95/p99)";
+	for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+	{
+		FrameTimings::getPercentiles(timings, stage, percentiles, values, 3);
+		msg += "\n" + string(FrameTimings::getStageName(stage)) + ": " + ofToString(values[0] * 0.001f, 2) + "/" + ofToString(values[1] * 0.001f, 2) + "/" + ofToString(values[2] * 0.001f, 2);
+	}
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::beginStereo(const ofMatrix4x4 &leftViewProjection, const ofMatrix4x4 &rightViewProjection)
+{
+	GLfloat eyeViewProjection[32];
+	memcpy(eyeViewProjection, leftViewProjection.getPtr(), 16 * sizeof(GLfloat));
+	memcpy(eyeViewProjection + 16, rightViewProjection.getPtr(), 16 * sizeof(GLfloat));
+
+	stereoShader->begin();
+	stereoShader->setUniformMatrix4fv("eyeViewProjection", eyeViewProjection, 2);
+	stereoShader->setUniform1i("useTexture", 0);
+	stereoShader->setUniform1i("tex0", 0);
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::endStereo()
+{
+	stereoShader->end();
+}
+
 //--------------------------------------------------------------
 const ofRectangle& ParallaxBarrierApp::getViewport()
 {
 	return this->viewport;
 }
 
+//--------------------------------------------------------------
+const ofRectangle& ParallaxBarrierApp::getEyeViewport()
+{
+	return this->eyeViewport;
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::drawViews()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
+
+	ofPushMatrix();
+	if (ofGetWindowHeight() > parallaxBarrier->getScreenResolutionHeight())
+	{
+		ofTranslate(0, ofGetWindowHeight() - parallaxBarrier->getScreenResolutionHeight());
+	}
+
+	//reduced width targets are drawn with their own viewport
+	bool eyeViewportScaled = parallaxBarrier->getEyeResolutionWidth() != parallaxBarrier->getScreenResolutionWidth();
+
+	if (parallaxBarrier->isLayeredStereo())
+	{
+		//draw both images in a single pass into the layered texture
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ofPushView();
+		if (eyeViewportScaled)
+			glViewport(0, 0, eyeViewport.width, eyeViewport.height);
+		drawStereo();
+		ofPopView();
+	}
+	else
+	{
+		if (maskColumns)
+		{
+			//column maps are needed before drawing to build the stencil mask
+			parallaxBarrier->updatePoints(leftEyePosition, rightEyePosition, invertBarrier);
+			drawColumnMask();
+
+			glEnable(GL_STENCIL_TEST);
+			glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+			glStencilFunc(GL_EQUAL, 1, 1);
+		}
+
+		//draw left image and load into left texture
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ofPushView();
+		if (eyeViewportScaled)
+			glViewport(0, 0, eyeViewport.width, eyeViewport.height);
+		drawLeft();
+		ofPopView();
+
+		if (maskColumns)
+		{
+			glStencilFunc(GL_EQUAL, 2, 2);
+		}
+
+		//draw right image and load into right texture
+		glDrawBuffer(GL_COLOR_ATTACHMENT1);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ofPushView();
+		if (eyeViewportScaled)
+			glViewport(0, 0, eyeViewport.width, eyeViewport.height);
+		drawRight();
+		ofPopView();
+
+		if (maskColumns)
+		{
+			glDisable(GL_STENCIL_TEST);
+		}
+	}
+
+	ofPopMatrix();
+
+	//disable fbo and use screen
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierApp::addDamagedRegion(const ofRectangle &region)
+{
+	if (parallaxBarrier == NULL)
+		return;
+
+	//views are drawn top down, the kernels address texture rows bottom up
+	parallaxBarrier->addDamagedRegion(ofRectangle(region.x, parallaxBarrier->getScreenResolutionHeight() - region.y - region.height, region.width, region.height));
+}
+
 //--------------------------------------------------------------
 void ParallaxBarrierApp::keyReleased(int key)
 {
 	if(key=='f')
 		ofxFensterManager::get()->getPrimaryWindow()->toggleFullscreen();
-	if(key=='=')
-		invertLimit++;
-	if(key=='-')
-		invertLimit--;
+	if(key=='=' && parallaxBarrier != NULL)
+		parallaxBarrier->setPhaseCount(parallaxBarrier->getPhaseCount() + 1);
+	if(key=='-' && parallaxBarrier != NULL)
+		parallaxBarrier->setPhaseCount(parallaxBarrier->getPhaseCount() - 1);
+	if(key=='i')
+		showTimings = !showTimings;
+	if(key=='c')
+		frameTimings.writeCsv(ofToDataPath("timings-" + ofGetTimestampString() + ".csv"));
+	if(key=='b')
+		frameTimings.writeBinary(ofToDataPath("timings-" + ofGetTimestampString() + ".bin"));
+	if(key=='m')
+		metricsWriter.write(ofToDataPath("metrics-" + ofGetTimestampString() + ".prom"));
+	if(key=='p' && parallaxBarrier != NULL)
+		parallaxBarrier->setPipelined(!parallaxBarrier->isPipelined());
+	if(key=='e')
+	{
+		if (eyeTraceWriter.isOpen())
+			eyeTraceWriter.close();
+		else
+			eyeTraceWriter.open(ofToDataPath("eyes-" + ofGetTimestampString() + ".etrc"));
+	}
+	if(key=='r' && parallaxBarrier != NULL)
+	{
+		if (frameCapture.isOpen())
+			frameCapture.close();
+		else
+			frameCapture.open(ofToDataPath("frames-" + ofGetTimestampString() + ".fcap"), *parallaxBarrier, captureContent);
+	}
+	if(key=='v')
+		framePacer.setVerticalSync(!framePacer.getVerticalSync());
+}
+
+FramePacer& ParallaxBarrierApp::getFramePacer()
+{
+	return framePacer;
 }
 
 int ParallaxBarrierApp::getScreenWidth()
@@ -3,6 +3,15 @@
 #include "ofMain.h"
 #include "ofxFensterManager.h"
 #include "ParallaxBarrier.h"
+#include "FramePacer.h"
+#include "FrameTimings.h"
+#include "Metrics.h"
+#include "EyeTracker.h"
+#include "EyeTrace.h"
+#include "StereoFrameSource.h"
+#include "FrameCapture.h"
+#include "BarrierSink.h"
+#include "opengl/OpenGLShader.h"
 
 class ParallaxBarrierApp;
 
@@ -10,12 +19,14 @@ class BarrierWindow: public ofxFensterListener {
 public:
 	BarrierWindow();
 	~BarrierWindow();
-	void setup();
 	void draw();
 	void keyReleased(int key, ofxFenster* window);
 
-	ofImage* barrierImage;
+	ParallaxBarrier* parallaxBarrier;
 	ParallaxBarrierApp* parallaxBarrierApp;
+
+private:
+	bool verticalSyncApplied;
 };
 
 class ParallaxBarrierApp : public ofBaseApp {
@@ -28,38 +39,127 @@ public:
 	void setup();
 	virtual void setupApp() {};
 	// 'initializeParallaxBarrier' method must be called from 'setupApp' method
-	void initializeParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, int screenOffsetX = 0, int screenOffsetY = 0);
+	void initializeParallaxBarrier(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, int screenOffsetX = 0, int screenOffsetY = 0, int flags = 0, float eyeResolutionScale = 1.f, int screenFormat = PARALLAX_BARRIER_SCREEN_RGBA8, int barrierFormat = PARALLAX_BARRIER_BARRIER_RGBA8);
 
 	// ParallaxBarrier apps only need to implement drawLeft and drawRight
 	void draw();
 	virtual void drawLeft() {};
 	virtual void drawRight() {};
+	// when initialized with PARALLAX_BARRIER_LAYERED_STEREO apps implement drawStereo instead,
+	// submitting scene geometry once between beginStereo and endStereo
+	virtual void drawStereo() {};
 
 	int getScreenWidth();
 	int getScreenHeight();
 	const ofRectangle& getViewport();
+	// viewport of the left/right render targets, narrower than the screen 
+	// when the barrier is initialized with an eye resolution scale below 1
+	const ofRectangle& getEyeViewport();
+
+	// region of the views that changed since the last frame, in drawing coordinates (see drawLeft/drawRight).
+	// Only used when damage tracking is enabled (ParallaxBarrier::setDamageTracking in 'setupApp'),
+	// then every change of the views must be reported before 'draw' composites them
+	void addDamagedRegion(const ofRectangle &region);
 
 	void keyReleased(int key);
 
-	bool updateBarrier;
+	FramePacer& getFramePacer();
 
 protected:
 	int screenOffsetX, screenOffsetY;
 
 	// Eye positions need to be 
-	// updated in app 'update' method
+	// updated in app 'update' method,
+	// unless an eye tracker is set
 	ofVec3f leftEyePosition;
 	ofVec3f rightEyePosition;
+	// time the eye positions were sampled (ofGetElapsedTimeMicros), 0 when unknown
+	unsigned long long eyeSampleTime;
 	bool invertBarrier;
-	int invertCounter;
-	int invertLimit;
+
+	// when set (in 'setupApp'), column maps are computed before the views are drawn and 
+	// each view is stencil masked to the screen columns it will be displayed in.
+	// Not used with layered stereo
+	bool maskColumns;
+
+	// when set (in 'setupApp'), the tracker is started by 'setup' and owned by the app.
+	// Its newest sample sets the eye positions of every composited frame
+	EyeTracker* eyeTracker;
+
+	// when set (in 'setupApp'), the views are the frames of the clip instead of drawLeft/drawRight.
+	// Owned by the app, opened with the view size of the barrier (see getEyeViewport)
+	StereoFrameSource* frameSource;
+
+	// when set (in 'setupApp'), the sink is started by 'setup' and owned by the app.
+	// The barrier columns of every composited frame are sent to it (e.g. StreamBarrierSink
+	// for a barrier controller), the barrier window is still drawn
+	BarrierSink* barrierSink;
+
+	// screen/barrier presentation pacing, vertical sync can be enabled in 'setupApp'.
+	// With several barrier phases (ParallaxBarrier::setPhaseCount, '='/'-' keys) 
+	// each composited frame shows the phase of its frame id, so phases follow the presented pairs
+	FramePacer framePacer;
+
+	// per frame stage timings, percentiles are shown with 'i', 
+	// 'c'/'b' dump them to a csv/binary file in the data folder
+	FrameTimings frameTimings;
+	bool showTimings;
+
+	// runtime metrics (MetricsRegistry) are written in Prometheus text format to 'metricsFileName' 
+	// every 'metricsInterval' seconds when set (in 'setupApp'), 'm' writes them to the data folder.
+	// Files are written by a background thread (MetricsFileWriter)
+	string metricsFileName;
+	float metricsInterval;
+
+	// eye trace recording (see EyeTrace): every composited frame appends its eye positions and 
+	// stage timings to 'eyeTraceFileName' when set (in 'setupApp'), 'e' starts/stops a recording 
+	// in the data folder. When 'eyeTraceReplayFileName' is set the recorded eye positions replace
+	// the eye tracker: at the recorded rate, or with 'eyeTraceReplayRealtime' unset one record per 
+	// composited frame, so every run composites the same frames as fast as it can
+	string eyeTraceFileName;
+	string eyeTraceReplayFileName;
+	bool eyeTraceReplayRealtime;
+
+	// frame capture (see FrameCapture): composited frames are read back asynchronously and written
+	// to 'captureFileName' when set (in 'setupApp'), 'r' starts/stops a capture in the data folder.
+	// 'captureContent' selects screen/barrier pixels or the column maps of each frame
+	string captureFileName;
+	int captureContent;
 
 	ParallaxBarrier* parallaxBarrier;
 
 	ofRectangle viewport;
+	ofRectangle eyeViewport;
+
+	// single pass stereo: the modelview matrix holds only the scene transformation, 
+	// view-projection matrices (view * projection, as given by ofCamera) are applied per eye layer.
+	// Textured geometry needs the 'useTexture' uniform of stereoShader set to 1
+	void beginStereo(const ofMatrix4x4 &leftViewProjection, const ofMatrix4x4 &rightViewProjection);
+	void endStereo();
+	OpenGLShader* stereoShader;
 
 private:
 	ofxFenster* barrierWindow;
+
+	void drawViews();
+	void drawColumnMask();
+	void drawTimings(string &msg);
+	void updateMetrics(const FrameTiming &frameTiming, bool frameComposited);
+	void replayEyeTrace();
+
+	MetricHistogram* stageMetrics[FRAME_TIMING_STAGES];
+	MetricCounter* framesMetric;
+	MetricCounter* skippedFramesMetric;
+	MetricsFileWriter metricsWriter;
+
+	EyeTraceWriter eyeTraceWriter;
+	EyeTraceReader eyeTraceReplay;
+	FrameCapture frameCapture;
+	size_t eyeTraceReplayRecord;
+	unsigned long long eyeTraceReplayStartTime;
+
+	// vertical sync applied to the screen window's context, -1 before the first frame
+	int screenVerticalSync;
 	
 	GLuint frameBufferObject;
 	GLuint frameBufferDepthTexture;
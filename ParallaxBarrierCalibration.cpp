@@ -0,0 +1,247 @@
+#include "ParallaxBarrierCalibration.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "ofUtils.h"
+
+ParallaxBarrierCalibration::ParallaxBarrierCalibration(float width, int screenResolutionWidth, int barrierResolutionWidth, const CalibrationGeometry &initialGeometry)
+{
+	_width = width;
+	_screenResolutionWidth = screenResolutionWidth;
+	_barrierResolutionWidth = barrierResolutionWidth;
+	_geometry = initialGeometry;
+	_observedColumns = 0;
+
+	_threads = max(1, (int) thread::hardware_concurrency());
+	_spacingSteps = CALIBRATION_DEFAULT_SPACING_STEPS;
+	_positionSteps = CALIBRATION_DEFAULT_POSITION_STEPS;
+	_angleSteps = CALIBRATION_DEFAULT_ANGLE_STEPS;
+	_rounds = CALIBRATION_DEFAULT_ROUNDS;
+
+	_error = 1.f;
+	_evaluationCount = 0;
+	_calibrationTime = 0;
+}
+
+ParallaxBarrierCalibration::~ParallaxBarrierCalibration()
+{
+}
+
+void ParallaxBarrierCalibration::addObservation(const CalibrationObservation &observation)
+{
+	if ((int) observation.screenPoints.size() != _screenResolutionWidth)
+	{
+		ofLogWarning("ParallaxBarrierCalibration") << "observation has " << observation.screenPoints.size() << " columns, expected " << _screenResolutionWidth;
+		return;
+	}
+
+	_observations.push_back(observation);
+	_observedColumns += _screenResolutionWidth - count(observation.screenPoints.begin(), observation.screenPoints.end(), 0);
+}
+
+void ParallaxBarrierCalibration::clearObservations()
+{
+	_observations.clear();
+	_observedColumns = 0;
+}
+
+int ParallaxBarrierCalibration::getObservationCount()
+{
+	return _observations.size();
+}
+
+void ParallaxBarrierCalibration::setThreads(int threads)
+{
+	_threads = max(1, threads);
+}
+
+void ParallaxBarrierCalibration::setSteps(int spacingSteps, int positionSteps, int angleSteps)
+{
+	_spacingSteps = max(1, spacingSteps);
+	_positionSteps = max(1, positionSteps);
+	_angleSteps = max(1, angleSteps);
+}
+
+void ParallaxBarrierCalibration::setRounds(int rounds)
+{
+	_rounds = max(1, rounds);
+}
+
+CalibrationGeometry ParallaxBarrierCalibration::calibrate(const CalibrationRange &range)
+{
+	unsigned long long startTime = ofGetElapsedTimeMicros();
+	_evaluationCount = 0;
+
+	if (_observations.empty() || _observedColumns == 0)
+	{
+		ofLogWarning("ParallaxBarrierCalibration") << "no observed columns, geometry unchanged";
+		_calibrationTime = 0;
+		return _geometry;
+	}
+
+	Candidate best;
+	best.geometry = _geometry;
+	best.mismatches = _observedColumns;
+	best.index = -1;
+	CalibrationRange roundRange = range;
+	for (int round = 0; round < _rounds; round++)
+	{
+		Candidate roundBest;
+		searchRound(best.geometry, roundRange, roundBest);
+		//even step counts leave the previous best off the grid, a round must not make it worse
+		if (roundBest.index >= 0 && roundBest.mismatches <= best.mismatches)
+			best = roundBest;
+
+		//next round samples one grid step around the best candidate
+		roundRange.spacing *= _spacingSteps > 1? 2.f / (_spacingSteps - 1) : 1.f;
+		roundRange.positionX *= _positionSteps > 1? 2.f / (_positionSteps - 1) : 1.f;
+		roundRange.positionZ *= _positionSteps > 1? 2.f / (_positionSteps - 1) : 1.f;
+		roundRange.yaw *= _angleSteps > 1? 2.f / (_angleSteps - 1) : 1.f;
+	}
+
+	_geometry = best.geometry;
+	_error = (float) best.mismatches / _observedColumns;
+	_calibrationTime = ofGetElapsedTimeMicros() - startTime;
+
+	return _geometry;
+}
+
+void ParallaxBarrierCalibration::searchRound(const CalibrationGeometry &center, const CalibrationRange &range, Candidate &best)
+{
+	atomic<int> nextCandidate(0);
+	atomic<unsigned long long> bestMismatches(_observedColumns);
+	vector<Candidate> threadBest(_threads);
+	vector<thread> workers;
+	for (int i = 0; i < _threads; i++)
+	{
+		workers.push_back(thread(&ParallaxBarrierCalibration::searchCandidates, this, ref(center), ref(range), ref(nextCandidate), ref(bestMismatches), ref(threadBest[i])));
+	}
+	for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		it->join();
+	}
+
+	//ties go to the lowest candidate index so results do not depend on scheduling
+	best = threadBest[0];
+	for (vector<Candidate>::iterator it = threadBest.begin(); it != threadBest.end(); ++it)
+	{
+		if (it->index < 0)
+			continue;
+		if (best.index < 0 || it->mismatches < best.mismatches || (it->mismatches == best.mismatches && it->index < best.index))
+			best = *it;
+	}
+
+	for (vector<Candidate>::iterator it = threadBest.begin(); it != threadBest.end(); ++it)
+	{
+		_evaluationCount += it->evaluations;
+	}
+}
+
+void ParallaxBarrierCalibration::searchCandidates(const CalibrationGeometry &center, const CalibrationRange &range, atomic<int> &nextCandidate, atomic<unsigned long long> &bestMismatches, Candidate &best)
+{
+	//each worker owns its rasterizer, model state is not shared
+	ParallaxBarrierRasterizer rasterizer(_width, _screenResolutionWidth, _barrierResolutionWidth, center.spacing, center.position, center.viewDirection, center.upDirection);
+
+	int offsetStart = center.screenOffsetX - range.screenOffsetX;
+	int offsetCount = 2 * range.screenOffsetX + 1;
+	vector<unsigned long long> mismatches(offsetCount);
+
+	best.index = -1;
+	best.mismatches = 0;
+	best.evaluations = 0;
+
+	int candidateCount = _spacingSteps * _positionSteps * _positionSteps * _angleSteps;
+	for (int i = nextCandidate++; i < candidateCount; i = nextCandidate++)
+	{
+		//candidate index to grid steps
+		int spacingStep = i % _spacingSteps;
+		int positionXStep = (i / _spacingSteps) % _positionSteps;
+		int positionZStep = (i / (_spacingSteps * _positionSteps)) % _positionSteps;
+		int angleStep = i / (_spacingSteps * _positionSteps * _positionSteps);
+
+		CalibrationGeometry geometry = center;
+		geometry.spacing = getStepValue(center.spacing, range.spacing, spacingStep, _spacingSteps);
+		geometry.position.x = getStepValue(center.position.x, range.positionX, positionXStep, _positionSteps);
+		geometry.position.z = getStepValue(center.position.z, range.positionZ, positionZStep, _positionSteps);
+		geometry.viewDirection = center.viewDirection.getRotated(getStepValue(0, range.yaw, angleStep, _angleSteps), center.upDirection);
+
+		if (geometry.spacing <= 0)
+			continue;
+
+		rasterizer.setSpacing(geometry.spacing);
+		rasterizer.setPosition(geometry.position);
+		rasterizer.setViewDirection(geometry.viewDirection);
+
+		fill(mismatches.begin(), mismatches.end(), 0);
+		vector<unsigned long long>::iterator bestOffset = mismatches.begin();
+		bool pruned = false;
+		for (vector<CalibrationObservation>::const_iterator it = _observations.begin(), end = _observations.end(); it != end && !pruned; ++it)
+		{
+			rasterizer.update(it->leftEyePosition, it->rightEyePosition);
+			scoreOffsets(rasterizer.getScreenPoints(), it->screenPoints, offsetStart, mismatches);
+			best.evaluations++;
+
+			//mismatches only grow, a candidate already worse than the best can not win (ties are kept)
+			bestOffset = min_element(mismatches.begin(), mismatches.end());
+			pruned = *bestOffset > bestMismatches.load(memory_order_relaxed);
+		}
+
+		if (!pruned && (best.index < 0 || *bestOffset < best.mismatches))
+		{
+			geometry.screenOffsetX = offsetStart + (bestOffset - mismatches.begin());
+			best.geometry = geometry;
+			best.mismatches = *bestOffset;
+			best.index = i;
+
+			unsigned long long currentBest = bestMismatches.load(memory_order_relaxed);
+			while (*bestOffset < currentBest && !bestMismatches.compare_exchange_weak(currentBest, *bestOffset, memory_order_relaxed));
+		}
+	}
+}
+
+void ParallaxBarrierCalibration::scoreOffsets(const signed char *screenPoints, const vector<signed char> &observedPoints, int offsetStart, vector<unsigned long long> &mismatches)
+{
+	for (int i = 0, offsetCount = mismatches.size(); i < offsetCount; i++)
+	{
+		//physical column 'p' shows rendered column 'p - offset', columns outside the rendered screen never match
+		int offset = offsetStart + i;
+		int start = max(0, offset), end = min(_screenResolutionWidth, _screenResolutionWidth + offset);
+		unsigned long long offsetMismatches = 0;
+		for (int p = 0; p < _screenResolutionWidth; p++)
+		{
+			signed char observed = observedPoints[p];
+			if (observed != 0 && (p < start || p >= end || screenPoints[p - offset] != observed))
+				offsetMismatches++;
+		}
+		mismatches[i] += offsetMismatches;
+	}
+}
+
+float ParallaxBarrierCalibration::getStepValue(float center, float range, int step, int steps)
+{
+	if (steps <= 1)
+		return center;
+
+	return center + range * (2.f * step / (steps - 1) - 1.f);
+}
+
+const CalibrationGeometry& ParallaxBarrierCalibration::getGeometry()
+{
+	return _geometry;
+}
+
+float ParallaxBarrierCalibration::getError()
+{
+	return _error;
+}
+
+unsigned long long ParallaxBarrierCalibration::getEvaluationCount()
+{
+	return _evaluationCount;
+}
+
+unsigned long long ParallaxBarrierCalibration::getCalibrationTime()
+{
+	return _calibrationTime;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+
+#include "ofVec3f.h"
+
+#include "ParallaxBarrierRasterizer.h"
+
+#define CALIBRATION_DEFAULT_SPACING_STEPS 41
+#define CALIBRATION_DEFAULT_POSITION_STEPS 9
+#define CALIBRATION_DEFAULT_ANGLE_STEPS 9
+#define CALIBRATION_DEFAULT_ROUNDS 4
+
+using namespace std;
+
+// one measurement: eye positions and the view seen at every physical screen column
+// (-1 left, 1 right, 0 unknown, same layout as ParallaxBarrierRasterizer screen points),
+// e.g. from camera captures of left/right test patterns taken from the eye positions
+struct CalibrationObservation
+{
+	ofVec3f leftEyePosition;
+	ofVec3f rightEyePosition;
+	vector<signed char> screenPoints;
+};
+
+struct CalibrationGeometry
+{
+	float spacing;
+	int screenOffsetX;
+	ofVec3f position;
+	ofVec3f viewDirection;
+	ofVec3f upDirection;
+};
+
+// half widths of the searched intervals around the initial geometry,
+// 'yaw' rotates the view direction around the up direction (degrees)
+struct CalibrationRange
+{
+	float spacing;
+	int screenOffsetX;
+	float positionX;
+	float positionZ;
+	float yaw;
+};
+
+// ParallaxBarrierCalibration searches the geometry that best explains a set of observations:
+// - spacing, position (x, z) and yaw are sampled on a grid that is refined around the best
+//   candidate every round, candidates are evaluated in parallel (one rasterizer per thread)
+// - every screen offset in range is scored from a single model evaluation, a rendered column
+//   'c' is seen at physical column 'c + screenOffsetX'
+// - a candidate stops being evaluated as soon as it is worse than the best one found by any thread
+// - column maps are periodic, so the error only drops close to the right spacing (a few tenths
+//   of a percent) and distance, their steps must be finer than that, position x and yaw are smooth
+// - the error is the fraction of known observed columns that show the wrong view
+class ParallaxBarrierCalibration
+{
+public:
+	ParallaxBarrierCalibration(float width, int screenResolutionWidth, int barrierResolutionWidth, const CalibrationGeometry &initialGeometry);
+	virtual ~ParallaxBarrierCalibration();
+
+	// 'screenPoints' must hold one value per screen column
+	void addObservation(const CalibrationObservation &observation);
+	void clearObservations();
+	int getObservationCount();
+
+	void setThreads(int threads);
+	void setSteps(int spacingSteps, int positionSteps, int angleSteps);
+	void setRounds(int rounds);
+
+	// returns the best geometry and keeps it as the initial geometry of the next call
+	CalibrationGeometry calibrate(const CalibrationRange &range);
+
+	const CalibrationGeometry& getGeometry();
+	// fraction of observed columns showing the wrong view with the best geometry
+	float getError();
+	// model evaluations (candidate and observation pairs) and duration in microseconds of the last 'calibrate'
+	unsigned long long getEvaluationCount();
+	unsigned long long getCalibrationTime();
+
+private:
+	struct Candidate
+	{
+		CalibrationGeometry geometry;
+		unsigned long long mismatches;
+		int index;
+		unsigned long long evaluations;
+	};
+
+	float _width;
+	int _screenResolutionWidth;
+	int _barrierResolutionWidth;
+	CalibrationGeometry _geometry;
+	vector<CalibrationObservation> _observations;
+	unsigned long long _observedColumns;
+
+	int _threads;
+	int _spacingSteps;
+	int _positionSteps;
+	int _angleSteps;
+	int _rounds;
+
+	float _error;
+	unsigned long long _evaluationCount;
+	unsigned long long _calibrationTime;
+
+	void searchRound(const CalibrationGeometry &center, const CalibrationRange &range, Candidate &best);
+	void searchCandidates(const CalibrationGeometry &center, const CalibrationRange &range, atomic<int> &nextCandidate, atomic<unsigned long long> &bestMismatches, Candidate &best);
+	void scoreOffsets(const signed char *screenPoints, const vector<signed char> &observedPoints, int offsetStart, vector<unsigned long long> &mismatches);
+
+	static float getStepValue(float center, float range, int step, int steps);
+};
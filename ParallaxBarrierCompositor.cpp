@@ -0,0 +1,106 @@
+#include "ParallaxBarrierCompositor.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+static inline void samplePixel(const ofPixels &pixels, float x, int y, unsigned char *color, int channels)
+{
+	int width = pixels.getWidth();
+	int sourceChannels = pixels.getNumChannels();
+	const unsigned char *row = pixels.getPixels() + (size_t) y * width * sourceChannels;
+
+	// same sample position and clamping as the kernel sampler
+	float position = x - 0.5f;
+	int x0 = (int) floor(position);
+	float fraction = position - x0;
+	int x1 = min(max(x0 + 1, 0), width - 1);
+	x0 = min(max(x0, 0), width - 1);
+
+	for (int c = 0; c < channels; c++)
+	{
+		if (c >= sourceChannels)
+		{
+			color[c] = 255;
+		}
+		else
+		{
+			color[c] = (unsigned char) (row[x0 * sourceChannels + c] * (1.f - fraction) + row[x1 * sourceChannels + c] * fraction + 0.5f);
+		}
+	}
+}
+
+bool ParallaxBarrierCompositor::compositeScreen(const signed char* screenPoints, const ofPixels &leftPixels, const ofPixels &rightPixels, ofPixels &screenPixels)
+{
+	int width = screenPixels.getWidth();
+	int height = screenPixels.getHeight();
+	int channels = screenPixels.getNumChannels();
+	unsigned char *screen = screenPixels.getPixels();
+
+	const ofPixels *eyes[2] = { &leftPixels, &rightPixels };
+	for (int eye = 0; eye < 2; eye++)
+	{
+		if (eyes[eye]->getPixels() == NULL || eyes[eye]->getWidth() <= 0 || eyes[eye]->getNumChannels() <= 0 || (int) eyes[eye]->getHeight() != height)
+			return false;
+	}
+
+	for (int j = 0; j < height; j++)
+	{
+		unsigned char *screenRow = screen + (size_t) j * width * channels;
+
+		for (int i = 0; i < width; i++)
+		{
+			unsigned char *color = screenRow + i * channels;
+
+			if (screenPoints[i] == 0)
+			{
+				fill_n(color, channels, 0);
+				if (channels == 4)
+					color[3] = 255;
+				continue;
+			}
+
+			//views are read with their own size, left and right may differ
+			const ofPixels &eyePixels = screenPoints[i] == -1? leftPixels : rightPixels;
+			int eyeWidth = eyePixels.getWidth();
+			int eyeChannels = eyePixels.getNumChannels();
+			if (eyeWidth == width)
+			{
+				const unsigned char *source = eyePixels.getPixels() + ((size_t) j * width + i) * eyeChannels;
+				for (int c = 0; c < channels; c++)
+				{
+					color[c] = c < eyeChannels? source[c] : 255;
+				}
+			}
+			else
+			{
+				samplePixel(eyePixels, (i + 0.5f) * eyeWidth / width, j, color, channels);
+			}
+		}
+	}
+
+	return true;
+}
+
+void ParallaxBarrierCompositor::compositeBarrier(const signed char* barrierPoints, ofPixels &barrierPixels)
+{
+	int width = barrierPixels.getWidth();
+	int height = barrierPixels.getHeight();
+	int channels = barrierPixels.getNumChannels();
+	unsigned char *barrier = barrierPixels.getPixels();
+
+	//build one row and replicate it, the pattern only varies per column
+	for (int i = 0; i < width; i++)
+	{
+		fill_n(barrier + i * channels, channels, barrierPoints[i] == 1? 255 : 0);
+		if (channels == 4)
+			barrier[i * channels + 3] = 255;
+	}
+
+	size_t rowSize = (size_t) width * channels;
+	for (int j = 1; j < height; j++)
+	{
+		copy(barrier, barrier + rowSize, barrier + j * rowSize);
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ofPixels.h"
+
+// CPU version of screenKernel.cl and barrierKernel.cl, for rendering without 
+// OpenGL/OpenCL contexts. Destination pixels must be allocated by the caller,
+// any channel count is accepted (alpha, when present, is always opaque)
+class ParallaxBarrierCompositor
+{
+public:
+	// left/right pixels narrower than the screen are resampled with linear filtering, 
+	// false (screen left unchanged) when a view is empty or its height differs from the screen
+	static bool compositeScreen(const signed char* screenPoints, const ofPixels &leftPixels, const ofPixels &rightPixels, ofPixels &screenPixels);
+	static void compositeBarrier(const signed char* barrierPoints, ofPixels &barrierPixels);
+};
@@ -0,0 +1,223 @@
+#include "ParallaxBarrierCrosstalk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+
+#ifdef CROSSTALK_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+ParallaxBarrierCrosstalk::ParallaxBarrierCrosstalk(float width, float spacing, int screenResolutionWidth, int barrierResolutionWidth)
+{
+	_modelWidth = width / spacing;
+	_screenResolutionWidth = screenResolutionWidth;
+	_barrierResolutionWidth = barrierResolutionWidth;
+}
+
+ParallaxBarrierCrosstalk::~ParallaxBarrierCrosstalk()
+{
+}
+
+CrosstalkResult ParallaxBarrierCrosstalk::simulate(const signed char* screenPoints, const signed char* barrierPoints, ofVec2f const &modelLeftEyePosition, ofVec2f const &modelRightEyePosition)
+{
+	CrosstalkResult result;
+	traceEye(screenPoints, barrierPoints, modelLeftEyePosition, -1, result.left);
+	traceEye(screenPoints, barrierPoints, modelRightEyePosition, 1, result.right);
+	result.modelUpdated = true;
+	return result;
+}
+
+static inline int lowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int) index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+#ifdef CROSSTALK_SSE2
+static inline int countBits(int mask)
+{
+	mask = mask - ((mask >> 1) & 0x5555);
+	mask = (mask & 0x3333) + ((mask >> 2) & 0x3333);
+	mask = (mask + (mask >> 4)) & 0x0f0f;
+	return (mask + (mask >> 8)) & 0x1f;
+}
+#endif
+
+// bit 'i' is set when column 'start + i' (of 16) starts a new run, column 0 never does
+static inline unsigned int findRunStarts(const signed char* points, int start, int end)
+{
+	unsigned int runStarts = 0;
+#ifdef CROSSTALK_SSE2
+	if (start > 0 && start + 16 <= end)
+	{
+		__m128i columns = _mm_loadu_si128((const __m128i*) &points[start]);
+		__m128i previousColumns = _mm_loadu_si128((const __m128i*) &points[start - 1]);
+		return ~_mm_movemask_epi8(_mm_cmpeq_epi8(columns, previousColumns)) & 0xffff;
+	}
+#endif
+	for (int i = max(start, 1); i < min(start + 16, end); i++)
+	{
+		if (points[i] != points[i - 1])
+			runStarts |= 1 << (i - start);
+	}
+	return runStarts;
+}
+
+// adds the number of columns in [start, end) showing each view to 'counts' (indexed by view + 1)
+static inline void countViews(const signed char* points, int start, int end, unsigned long long counts[3])
+{
+	int i = start;
+#ifdef CROSSTALK_SSE2
+	const __m128i left = _mm_set1_epi8(-1);
+	const __m128i black = _mm_setzero_si128();
+	for (; i + 16 <= end; i += 16)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i*) &points[i]);
+		int leftColumns = countBits(_mm_movemask_epi8(_mm_cmpeq_epi8(values, left)));
+		int blackColumns = countBits(_mm_movemask_epi8(_mm_cmpeq_epi8(values, black)));
+		counts[0] += leftColumns;
+		counts[1] += blackColumns;
+		counts[2] += 16 - leftColumns - blackColumns;
+	}
+#endif
+	for (; i < end; i++)
+	{
+		counts[points[i] + 1]++;
+	}
+}
+
+// first ray (of 'sampleCount') reaching the barrier at or after 'barrierColumn'
+static inline long long firstRay(double barrierColumn, double intercept, double inverseSlope, double sampleCount)
+{
+	return (long long) max(0., min(sampleCount, ceil((barrierColumn - intercept) * inverseSlope - 0.5)));
+}
+
+// adds the rays [startRay, endRay) to 'views' (indexed by view + 1)
+static inline void countRayViews(const signed char* screenPoints, long long startRay, long long endRay, unsigned long long views[3])
+{
+	int startColumn = (int) (startRay / CROSSTALK_SAMPLES_PER_COLUMN), endColumn = (int) (endRay / CROSSTALK_SAMPLES_PER_COLUMN);
+	int startSamples = (int) (startRay % CROSSTALK_SAMPLES_PER_COLUMN), endSamples = (int) (endRay % CROSSTALK_SAMPLES_PER_COLUMN);
+	if (startColumn == endColumn)
+	{
+		views[screenPoints[startColumn] + 1] += endSamples - startSamples;
+		return;
+	}
+
+	// rays of partially covered screen columns, then whole columns
+	if (startSamples > 0)
+	{
+		views[screenPoints[startColumn] + 1] += CROSSTALK_SAMPLES_PER_COLUMN - startSamples;
+		startColumn++;
+	}
+	if (endSamples > 0)
+		views[screenPoints[endColumn] + 1] += endSamples;
+
+	unsigned long long columnViews[3] = { 0, 0, 0 };
+	countViews(screenPoints, startColumn, endColumn, columnViews);
+	for (int i = 0; i < 3; i++)
+	{
+		views[i] += columnViews[i] * CROSSTALK_SAMPLES_PER_COLUMN;
+	}
+}
+
+void ParallaxBarrierCrosstalk::traceEye(const signed char* screenPoints, const signed char* barrierPoints, ofVec2f const &modelEyePosition, signed char eyeView, CrosstalkEyeResult &result)
+{
+	result.visible = result.leakage = result.darkBand = 0;
+
+	// eyes must be in front of the barrier
+	if (modelEyePosition.y <= 1.f)
+		return;
+
+	// the ray from the eye to screen point 'x' crosses the barrier at 'eye.x + (x - eye.x)*barrierRatio',
+	// for ray 'k' (screen point '(k + 0.5)*sampleWidth') the barrier column is '(k + 0.5)*slope + intercept',
+	// so the rays reaching barrier columns [b, b + 1) are [firstRay(b), firstRay(b + 1))
+	double barrierRatio = (modelEyePosition.y - 1.) / modelEyePosition.y;
+	double barrierScale = _barrierResolutionWidth / _modelWidth;
+	double sampleWidth = _modelWidth / ((double) _screenResolutionWidth * CROSSTALK_SAMPLES_PER_COLUMN);
+	double inverseSlope = 1. / (barrierRatio * barrierScale * sampleWidth);
+	double intercept = modelEyePosition.x * (1. - barrierRatio) * barrierScale;
+	double sampleCount = (double) _screenResolutionWidth * CROSSTALK_SAMPLES_PER_COLUMN;
+
+	unsigned long long visible = 0;
+	unsigned long long views[3] = { 0, 0, 0 };
+
+	// instead of tracing every ray, barrier runs are found 16 columns at a time and mapped back to ray ranges
+	int runStart = 0;
+	long long runStartRay = firstRay(0, intercept, inverseSlope, sampleCount), tracedStartRay = runStartRay;
+	for (int block = 0; block < _barrierResolutionWidth; block += 16)
+	{
+		for (unsigned int runStarts = findRunStarts(barrierPoints, block, _barrierResolutionWidth); runStarts != 0; runStarts &= runStarts - 1)
+		{
+			int column = block + lowestBit(runStarts);
+			long long ray = firstRay(column, intercept, inverseSlope, sampleCount);
+			if (barrierPoints[runStart] == 1 && runStartRay < ray)
+			{
+				visible += ray - runStartRay;
+				countRayViews(screenPoints, runStartRay, ray, views);
+			}
+			runStart = column;
+			runStartRay = ray;
+		}
+	}
+	long long tracedEndRay = firstRay(_barrierResolutionWidth, intercept, inverseSlope, sampleCount);
+	if (barrierPoints[runStart] == 1 && runStartRay < tracedEndRay)
+	{
+		visible += tracedEndRay - runStartRay;
+		countRayViews(screenPoints, runStartRay, tracedEndRay, views);
+	}
+
+	unsigned long long traced = tracedEndRay - tracedStartRay;
+	if (traced > 0)
+		result.visible = (float) visible / traced;
+	if (visible > 0)
+	{
+		result.leakage = (float) views[-eyeView + 1] / visible;
+		result.darkBand = (float) views[1] / visible;
+	}
+}
+
+static void sweepEyePositions(ParallaxBarrierCrosstalk *crosstalk, const ParallaxBarrierRasterizer &rasterizer, const vector<ofVec3f> &leftEyePositions, const vector<ofVec3f> &rightEyePositions, vector<CrosstalkResult> &results, ofVec3f const &eyeOffset, atomic<int> &nextEyePosition)
+{
+	//each worker owns its rasterizer, model state is not shared
+	ParallaxBarrierRasterizer workerRasterizer(rasterizer);
+	const ofMatrix4x4 &modelTransformation = workerRasterizer.getModelTransformation();
+
+	for (int i = nextEyePosition++; i < (int) results.size(); i = nextEyePosition++)
+	{
+		bool modelUpdated = workerRasterizer.update(leftEyePositions[i], rightEyePositions[i]);
+
+		//maps are computed for the tracked positions, the eyes are 'eyeOffset' away from them
+		ofVec3f modelLeftEyePosition = (leftEyePositions[i] + eyeOffset) * modelTransformation;
+		ofVec3f modelRightEyePosition = (rightEyePositions[i] + eyeOffset) * modelTransformation;
+		results[i] = crosstalk->simulate(workerRasterizer.getScreenPoints(), workerRasterizer.getBarrierPoints(), ofVec2f(modelLeftEyePosition.x, modelLeftEyePosition.z), ofVec2f(modelRightEyePosition.x, modelRightEyePosition.z));
+		results[i].modelUpdated = modelUpdated;
+	}
+}
+
+void ParallaxBarrierCrosstalk::sweep(const ParallaxBarrierRasterizer &rasterizer, const vector<ofVec3f> &leftEyePositions, const vector<ofVec3f> &rightEyePositions, vector<CrosstalkResult> &results, ofVec3f const &eyeOffset, int threads)
+{
+	results.resize(min(leftEyePositions.size(), rightEyePositions.size()));
+	if (threads <= 0)
+		threads = max(1, (int) thread::hardware_concurrency());
+
+	atomic<int> nextEyePosition(0);
+	vector<thread> workers;
+	for (int i = 0; i < threads; i++)
+	{
+		workers.push_back(thread(sweepEyePositions, this, ref(rasterizer), ref(leftEyePositions), ref(rightEyePositions), ref(results), ref(eyeOffset), ref(nextEyePosition)));
+	}
+	for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		it->join();
+	}
+}
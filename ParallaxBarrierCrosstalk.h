@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include "ofVec2f.h"
+#include "ofVec3f.h"
+
+#include "ParallaxBarrierRasterizer.h"
+
+// rays traced per screen column
+#define CROSSTALK_SAMPLES_PER_COLUMN 16
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CROSSTALK_SSE2
+#endif
+
+using namespace std;
+
+// fractions of the rays traced from one eye to the screen:
+// - visible: rays passing through a transparent barrier column
+// - leakage: visible rays reaching a column of the other eye view
+// - darkBand: visible rays reaching a black guard column
+// leakage and darkBand are relative to the visible rays
+struct CrosstalkEyeResult
+{
+	float visible;
+	float leakage;
+	float darkBand;
+};
+
+struct CrosstalkResult
+{
+	CrosstalkEyeResult left;
+	CrosstalkEyeResult right;
+	bool modelUpdated;
+};
+
+// ParallaxBarrierCrosstalk traces each eye view through the barrier column map onto the screen
+// column map (model coordinates, see ParallaxBarrierModel: screen at y 0, barrier at y 1):
+// - rays go to CROSSTALK_SAMPLES_PER_COLUMN points evenly spread inside each screen column,
+//   rays crossing the barrier plane outside the barrier are not counted
+// - rays are not traced one by one, barrier runs are mapped back to the range of rays
+//   crossing them; runs are found and screen views counted 16 columns at a time with SSE2
+//   when available (scalar otherwise)
+// - 'sweep' rasterizes and traces many eye positions in parallel, one rasterizer per thread
+class ParallaxBarrierCrosstalk
+{
+public:
+	ParallaxBarrierCrosstalk(float width, float spacing, int screenResolutionWidth, int barrierResolutionWidth);
+	virtual ~ParallaxBarrierCrosstalk();
+
+	// eye positions in model coordinates (see ParallaxBarrierRasterizer::getModelTransformation)
+	CrosstalkResult simulate(const signed char* screenPoints, const signed char* barrierPoints, ofVec2f const &modelLeftEyePosition, ofVec2f const &modelRightEyePosition);
+
+	// rasterizes the column maps for every eye pair (world coordinates) with copies of 'rasterizer'
+	// and simulates the eye pair moved by 'eyeOffset' (the tracking error, the same eye pair when 0),
+	// 'results' is resized to the number of eye pairs
+	void sweep(const ParallaxBarrierRasterizer &rasterizer, const vector<ofVec3f> &leftEyePositions, const vector<ofVec3f> &rightEyePositions, vector<CrosstalkResult> &results, ofVec3f const &eyeOffset = ofVec3f(0, 0, 0), int threads = 0);
+
+private:
+	float _modelWidth;
+	int _screenResolutionWidth;
+	int _barrierResolutionWidth;
+
+	// visible, leaked and dark ray counts, 'eyeView' is the screen point value of the eye (-1 left, 1 right)
+	void traceEye(const signed char* screenPoints, const signed char* barrierPoints, ofVec2f const &modelEyePosition, signed char eyeView, CrosstalkEyeResult &result);
+};
@@ -1,6 +1,8 @@
 #include "ParallaxBarrierModel.h"
 
-ParallaxBarrierModel::ParallaxBarrierModel(): _width(1.f)
+#include <algorithm>
+
+ParallaxBarrierModel::ParallaxBarrierModel(): _width(1.f), _iterationLimitReached(false)
 {
 }
 
@@ -8,13 +10,14 @@ ParallaxBarrierModel::~ParallaxBarrierModel()
 {
 }
 
-bool ParallaxBarrierModel::update(ofVec2f leftEyePosition, ofVec2f rightEyePosition)
+bool ParallaxBarrierModel::update(ofVec2f leftEyePosition, ofVec2f rightEyePosition, float phaseShift)
 {
 
 	float minPoint = getMinVisiblePoint(leftEyePosition, rightEyePosition);
 	float maxPoint = getMaxVisiblePoint(leftEyePosition, rightEyePosition);
 	_screenPoints.clear();
 	_barrierPoints.clear();
+	_iterationLimitReached = false;
 
 	if (minPoint == -1 || maxPoint == -1)
 	{
@@ -30,15 +33,17 @@ bool ParallaxBarrierModel::update(ofVec2f leftEyePosition, ofVec2f rightEyePosit
 	float leftShutterDistanceFraction = 1/leftEyePosition.y;
 	float BCoef = (rightEyePosition.x * rightShutterDistanceFraction - leftEyePosition.x * leftShutterDistanceFraction) / (1 - leftShutterDistanceFraction);
 	float ACoef = (1.f - rightShutterDistanceFraction) / (1.f - leftShutterDistanceFraction);
-	float cumulativeCoef1 = minPoint * ACoef;
+	//shifted start point, first zone width is (ACoef - 1) * minPoint + BCoef
+	float startPoint = minPoint - phaseShift * ((ACoef - 1) * minPoint + BCoef);
+	float cumulativeCoef1 = startPoint * ACoef;
 	float cumulativeCoef2 = 1;
 	int errorCounter = 0;
 	bool pair = true;
 
 
 	//initial point
-	newScreenPoint = minPoint;
-	screenPoints.push_back(newScreenPoint);
+	newScreenPoint = startPoint;
+	screenPoints.push_back(minPoint);
 	screenIterationPoint = newScreenPoint;
 
 	while (screenIterationPoint < maxPoint && errorCounter <= PARALLAX_BARRIER_MAX_ITERATIONS)
@@ -59,7 +64,8 @@ bool ParallaxBarrierModel::update(ofVec2f leftEyePosition, ofVec2f rightEyePosit
 		} 
 		else
 		{
-			screenPoints.push_back(newScreenPoint);
+			//zones ending before the visible range are empty
+			screenPoints.push_back(max(newScreenPoint, minPoint));
 		}
 		
 		
@@ -81,6 +87,7 @@ bool ParallaxBarrierModel::update(ofVec2f leftEyePosition, ofVec2f rightEyePosit
 
 	if (errorCounter > PARALLAX_BARRIER_MAX_ITERATIONS)
 	{
+		_iterationLimitReached = true;
 		return false;
 	}
 
@@ -236,3 +243,8 @@ const vector<float>& ParallaxBarrierModel::getBarrierPoints()
 	return _barrierPoints;
 }
 
+bool ParallaxBarrierModel::isIterationLimitReached()
+{
+	return _iterationLimitReached;
+}
+
@@ -20,20 +20,25 @@ using namespace std;
 // - Points in 'ScreenPoints' altarnate between 'Left Eye Start View Zone'/'Right Eye Start View Zone'
 // - First point in 'ShutterPoints' corresponds to the start of a non-transparent zone in the shutter 
 // - Points in 'ShutterPoints' altarnate between 'Translucid Start Zone'/'Non-Transparent Start Zone'
+// - 'phaseShift' moves the zones by a fraction [0, 1) of the first zone width towards the start of the
+//   screen, the first point is still the minimum visible point (repeated when the first left zone is not visible)
 class ParallaxBarrierModel
 {
 public:
 	ParallaxBarrierModel();
 	virtual ~ParallaxBarrierModel();
 
-	bool update(ofVec2f leftEyePosition, ofVec2f rightEyePosition);
+	bool update(ofVec2f leftEyePosition, ofVec2f rightEyePosition, float phaseShift = 0.f);
 
 	float getWidth();
 	void setWidth(float width);
 	const vector<float>& getScreenPoints();
 	const vector<float>& getBarrierPoints();
+	// true when the last 'update' failed after PARALLAX_BARRIER_MAX_ITERATIONS iterations
+	bool isIterationLimitReached();
 private:
 	float _width;
+	bool _iterationLimitReached;
 
 	vector<float> _screenPoints; 
 	vector<float> _barrierPoints;
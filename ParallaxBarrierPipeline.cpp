@@ -0,0 +1,178 @@
+#include "ParallaxBarrierPipeline.h"
+
+#include <cmath>
+
+ParallaxBarrierPipeline::ParallaxBarrierPipeline(const ParallaxBarrierRasterizer &rasterizer)
+{
+	_stopping = false;
+	_requestPending = false;
+	_pendingRasterizer = NULL;
+	_rasterizer = new ParallaxBarrierRasterizer(rasterizer);
+
+	//no maps until the first request completed
+	for (int i = 0; i < 3; i++)
+	{
+		_phaseMaps[i].generation = (unsigned long) -1;
+		_phaseMaps[i].phaseCount = 0;
+	}
+	_frontMaps = &_phaseMaps[0];
+	_readyMaps = &_phaseMaps[1];
+	_backMaps = &_phaseMaps[2];
+	_readyMapsPending = false;
+}
+
+ParallaxBarrierPipeline::~ParallaxBarrierPipeline()
+{
+	stop();
+	delete _pendingRasterizer;
+	delete _rasterizer;
+}
+
+void ParallaxBarrierPipeline::start()
+{
+	_stopping = false;
+	startThread(false, false);
+}
+
+void ParallaxBarrierPipeline::stop()
+{
+	{
+		lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_requestCondition.notify_all();
+	_readyCondition.notify_all();
+	waitForThread(true);
+}
+
+void ParallaxBarrierPipeline::setRasterizer(const ParallaxBarrierRasterizer &rasterizer)
+{
+	//copied outside of the lock, the worker only waits for the pointer swap
+	ParallaxBarrierRasterizer* pendingRasterizer = new ParallaxBarrierRasterizer(rasterizer);
+	{
+		lock_guard<std::mutex> lock(_mutex);
+		swap(_pendingRasterizer, pendingRasterizer);
+	}
+	delete pendingRasterizer;
+}
+
+void ParallaxBarrierPipeline::request(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier, int phaseCount, unsigned long generation)
+{
+	{
+		lock_guard<std::mutex> lock(_mutex);
+		_request.leftEyePosition = leftEyePosition;
+		_request.rightEyePosition = rightEyePosition;
+		_request.invertedBarrier = invertedBarrier;
+		_request.phaseCount = phaseCount;
+		_request.generation = generation;
+		_requestPending = true;
+	}
+	_requestCondition.notify_one();
+}
+
+bool ParallaxBarrierPipeline::acquire(unsigned long generation)
+{
+	unique_lock<std::mutex> lock(_mutex);
+
+	//front maps of an older geometry or phase count can not be used, wait for the current generation
+	if (_frontMaps->generation != generation)
+	{
+		_readyCondition.wait(lock, [&] { return _stopping || (_readyMapsPending && _readyMaps->generation == generation); });
+	}
+
+	if (!_readyMapsPending || _readyMaps->generation != generation)
+		return false;
+
+	swap(_frontMaps, _readyMaps);
+	_readyMapsPending = false;
+	return true;
+}
+
+const ParallaxBarrierPhaseMaps& ParallaxBarrierPipeline::getPhaseMaps()
+{
+	return *_frontMaps;
+}
+
+void ParallaxBarrierPipeline::threadedFunction()
+{
+	Request lastRequest;
+	bool lastRequestValid = false;
+
+	while (true)
+	{
+		Request request;
+		{
+			unique_lock<std::mutex> lock(_mutex);
+			_requestCondition.wait(lock, [&] { return _stopping || _requestPending; });
+			if (_stopping)
+				return;
+
+			request = _request;
+			_requestPending = false;
+			if (_pendingRasterizer != NULL)
+			{
+				swap(_rasterizer, _pendingRasterizer);
+				delete _pendingRasterizer;
+				_pendingRasterizer = NULL;
+			}
+		}
+
+		//the newest maps are already computed
+		if (lastRequestValid && request.generation == lastRequest.generation && request.phaseCount == lastRequest.phaseCount && request.invertedBarrier == lastRequest.invertedBarrier 
+			&& request.leftEyePosition == lastRequest.leftEyePosition && request.rightEyePosition == lastRequest.rightEyePosition)
+			continue;
+
+		computePhaseMaps(request, *_backMaps);
+		lastRequest = request;
+		lastRequestValid = true;
+
+		{
+			lock_guard<std::mutex> lock(_mutex);
+			swap(_backMaps, _readyMaps);
+			_readyMapsPending = true;
+		}
+		_readyCondition.notify_all();
+	}
+}
+
+void ParallaxBarrierPipeline::computePhaseMaps(const Request &request, ParallaxBarrierPhaseMaps &phaseMaps)
+{
+	int screenWidth = _rasterizer->getScreenResolutionWidth();
+	int barrierWidth = _rasterizer->getBarrierResolutionWidth();
+
+	phaseMaps.generation = request.generation;
+	phaseMaps.phaseCount = request.phaseCount;
+	phaseMaps.leftEyePosition = request.leftEyePosition;
+	phaseMaps.rightEyePosition = request.rightEyePosition;
+	phaseMaps.invertedBarrier = request.invertedBarrier;
+	phaseMaps.screenPoints.resize(request.phaseCount * screenWidth);
+	phaseMaps.barrierPoints.resize(request.phaseCount * barrierWidth);
+	phaseMaps.boundaries.resize(request.phaseCount);
+	phaseMaps.modelTime = 0;
+	phaseMaps.rasterizationTime = 0;
+	phaseMaps.modelFailures = 0;
+	phaseMaps.iterationLimits = 0;
+	phaseMaps.guardPixels = 0;
+
+	//same phases as ParallaxBarrier::updatePhasePoints
+	for (int phase = 0; phase < request.phaseCount; phase++)
+	{
+		float zoneShift = 2.f * phase / request.phaseCount;
+		bool phaseInverted = zoneShift >= 1.f;
+
+		if (!_rasterizer->update(request.leftEyePosition, request.rightEyePosition, request.invertedBarrier != phaseInverted, fmod(zoneShift, 1.f)))
+		{
+			phaseMaps.modelFailures++;
+			if (_rasterizer->getModel().isIterationLimitReached())
+				phaseMaps.iterationLimits++;
+		}
+		phaseMaps.modelTime += _rasterizer->getModelTime();
+		phaseMaps.rasterizationTime += _rasterizer->getRasterizationTime();
+		phaseMaps.guardPixels += _rasterizer->getErrorRatio();
+		phaseMaps.errorRatio = _rasterizer->getErrorRatio();
+		phaseMaps.boundaries[phase] = (int) (_rasterizer->getModel().getScreenPoints().size() + _rasterizer->getModel().getBarrierPoints().size());
+
+		copy(_rasterizer->getScreenPoints(), _rasterizer->getScreenPoints() + screenWidth, phaseMaps.screenPoints.begin() + phase * screenWidth);
+		copy(_rasterizer->getBarrierPoints(), _rasterizer->getBarrierPoints() + barrierWidth, phaseMaps.barrierPoints.begin() + phase * barrierWidth);
+	}
+}
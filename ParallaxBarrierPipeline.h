@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "ParallaxBarrierRasterizer.h"
+
+using namespace std;
+
+// column maps of every phase for one eye pair, one phase after the other (see ParallaxBarrier::setPhaseCount)
+struct ParallaxBarrierPhaseMaps
+{
+	// ParallaxBarrier geometry/phase count generation the maps were computed for
+	unsigned long generation;
+	int phaseCount;
+	ofVec3f leftEyePosition;
+	ofVec3f rightEyePosition;
+	bool invertedBarrier;
+
+	vector<signed char> screenPoints;
+	vector<signed char> barrierPoints;
+
+	// summed over the phases
+	unsigned long long modelTime;
+	unsigned long long rasterizationTime;
+	int modelFailures;
+	int iterationLimits;
+	int guardPixels;
+	// guard pixels of the last phase (see ParallaxBarrier::getErrorRatio)
+	int errorRatio;
+	// screen plus barrier boundaries of each phase
+	vector<int> boundaries;
+};
+
+// ParallaxBarrierPipeline computes column maps on its own thread:
+// - 'request' hands over the newest eye pair and returns at once, a request that was not 
+//   started yet is replaced
+// - maps are computed into a back buffer and published to a ready slot, 'acquire' swaps the 
+//   ready maps with the front maps read by the render thread, so neither thread waits for the other
+// - geometry changes ('setRasterizer') and phase count changes start a new generation,
+//   'acquire' only waits when the front maps are from an older generation
+class ParallaxBarrierPipeline : public ofThread
+{
+public:
+	ParallaxBarrierPipeline(const ParallaxBarrierRasterizer &rasterizer);
+	virtual ~ParallaxBarrierPipeline();
+
+	void start();
+	void stop();
+
+	// a copy of 'rasterizer' is used from the next request on
+	void setRasterizer(const ParallaxBarrierRasterizer &rasterizer);
+	void request(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier, int phaseCount, unsigned long generation);
+
+	// true when newer maps were swapped into the front maps
+	bool acquire(unsigned long generation);
+	const ParallaxBarrierPhaseMaps& getPhaseMaps();
+
+protected:
+	void threadedFunction();
+
+private:
+	struct Request
+	{
+		ofVec3f leftEyePosition;
+		ofVec3f rightEyePosition;
+		bool invertedBarrier;
+		int phaseCount;
+		unsigned long generation;
+	};
+
+	void computePhaseMaps(const Request &request, ParallaxBarrierPhaseMaps &phaseMaps);
+
+	// ofThread has a member named mutex
+	std::mutex _mutex;
+	condition_variable _requestCondition;
+	condition_variable _readyCondition;
+	bool _stopping;
+
+	Request _request;
+	bool _requestPending;
+	ParallaxBarrierRasterizer* _pendingRasterizer;
+
+	// only used by the worker thread
+	ParallaxBarrierRasterizer* _rasterizer;
+
+	ParallaxBarrierPhaseMaps _phaseMaps[3];
+	ParallaxBarrierPhaseMaps* _frontMaps;
+	ParallaxBarrierPhaseMaps* _readyMaps;
+	ParallaxBarrierPhaseMaps* _backMaps;
+	bool _readyMapsPending;
+};
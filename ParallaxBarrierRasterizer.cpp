@@ -0,0 +1,484 @@
+#include "ParallaxBarrierRasterizer.h"
+
+#include <algorithm>
+#include "ofUtils.h"
+
+ParallaxBarrierRasterizer::ParallaxBarrierRasterizer(float width, int screenResolutionWidth, int barrierResolutionWidth, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection)
+{
+	_width = width;
+	_screenResolutionWidth = screenResolutionWidth;
+	_barrierResolutionWidth = barrierResolutionWidth;
+	_spacing = spacing;
+	_position = position;
+	_viewDirection = viewDirection;
+	_upDirection = upDirection;
+	_screenInversePixelWidth = _screenResolutionWidth/_width;
+	_barrierInversePixelWidth = _barrierResolutionWidth/_width;
+	_modelScale = 1.f/spacing;
+	errorRatio = 0;
+	_fixedPoint = false;
+	_modelTime = 0;
+	_rasterizationTime = 0;
+
+	_screenPoints = new signed char[screenResolutionWidth];
+	_barrierPoints = new signed char[barrierResolutionWidth];
+	fill_n(_screenPoints, _screenResolutionWidth, 0);
+	fill_n(_barrierPoints, _barrierResolutionWidth, 0);
+
+	// initialize model transormation
+	updateModelTransformation();
+	_model.setWidth(_width*_modelScale);
+}
+
+ParallaxBarrierRasterizer::ParallaxBarrierRasterizer(const ParallaxBarrierRasterizer &other): _width(other._width), _screenResolutionWidth(other._screenResolutionWidth), _barrierResolutionWidth(other._barrierResolutionWidth), _spacing(other._spacing), _position(other._position), _viewDirection(other._viewDirection), _upDirection(other._upDirection), _barrierInversePixelWidth(other._barrierInversePixelWidth), _screenInversePixelWidth(other._screenInversePixelWidth), errorRatio(other.errorRatio), _fixedPoint(other._fixedPoint), _modelTime(other._modelTime), _rasterizationTime(other._rasterizationTime), _modelTransformation(other._modelTransformation), _modelScale(other._modelScale), _modelLeftEyePosition(other._modelLeftEyePosition), _modelRightEyePosition(other._modelRightEyePosition), _model(other._model)
+{
+	_screenPoints = new signed char[_screenResolutionWidth];
+	_barrierPoints = new signed char[_barrierResolutionWidth];
+	copy(other._screenPoints, other._screenPoints + _screenResolutionWidth, _screenPoints);
+	copy(other._barrierPoints, other._barrierPoints + _barrierResolutionWidth, _barrierPoints);
+}
+
+ParallaxBarrierRasterizer::~ParallaxBarrierRasterizer()
+{
+	delete[] _screenPoints;
+	delete[] _barrierPoints;
+}
+
+bool ParallaxBarrierRasterizer::update(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier, float phaseShift)
+{
+	ofVec3f modelLeftEyePosition3d = leftEyePosition * _modelTransformation;
+	ofVec3f modelRightEyePosition3d = rightEyePosition * _modelTransformation;
+
+	return update(ofVec2f(modelLeftEyePosition3d.x, modelLeftEyePosition3d.z), ofVec2f(modelRightEyePosition3d.x, modelRightEyePosition3d.z), invertedBarrier, phaseShift);
+}
+
+bool ParallaxBarrierRasterizer::update(ofVec2f const &modelLeftEyePosition, ofVec2f const &modelRightEyePosition, bool invertedBarrier, float phaseShift)
+{
+	unsigned long long startTime = ofGetElapsedTimeMicros();
+	errorRatio = 0;
+
+	_modelLeftEyePosition = modelLeftEyePosition;
+	_modelRightEyePosition = modelRightEyePosition;
+
+	//modify model for new eye positions
+	bool modelUpdated = _model.update(_modelLeftEyePosition, _modelRightEyePosition, phaseShift);
+
+	unsigned long long modelTime = ofGetElapsedTimeMicros();
+	_modelTime = modelTime - startTime;
+
+	//modify pixels
+	rasterize(invertedBarrier);
+
+	_rasterizationTime = ofGetElapsedTimeMicros() - modelTime;
+
+	return modelUpdated;
+}
+
+void ParallaxBarrierRasterizer::rasterize(bool invertedBarrier)
+{
+	errorRatio = 0;
+	if (_fixedPoint)
+	{
+		updateBarrierPointsFixed(invertedBarrier);
+		updateScreenPointsFixed(invertedBarrier);
+	}
+	else
+	{
+		updateBarrierPoints(invertedBarrier);
+		updateScreenPoints(invertedBarrier);
+	}
+}
+
+bool ParallaxBarrierRasterizer::isFixedPoint()
+{
+	return _fixedPoint;
+}
+
+void ParallaxBarrierRasterizer::setFixedPoint(bool fixedPoint)
+{
+	_fixedPoint = fixedPoint;
+}
+
+void ParallaxBarrierRasterizer::updateModelTransformation()
+{
+	ofMatrix4x4 modelScale, modelRotation, modelUpRotation, modelTranslation, modelCenterTranslation;
+	modelScale.makeScaleMatrix(_modelScale, _modelScale, _modelScale);
+
+	modelRotation.makeRotationMatrix(_viewDirection, ofVec3f(0,0,1));
+	modelUpRotation.makeRotationMatrix(modelRotation*_upDirection, ofVec3f(0,1,0));
+	modelTranslation.makeTranslationMatrix(ofVec3f(_width * 0.5,0,0));
+	modelCenterTranslation.makeTranslationMatrix(-_position);
+
+	_modelTransformation = modelCenterTranslation * modelRotation * modelUpRotation * modelTranslation * modelScale;
+}
+
+void ParallaxBarrierRasterizer::updateBarrierPoints(bool invertedBarrier)
+{
+	// points in the list are ordered pairs where 
+	// the first point indicates the start of a non-transparent pixel zone, and 
+	// the second point indicates the end of a non-transparent pixel zone
+	const vector<float>& points = _model.getBarrierPoints();
+
+	//initialize points array
+	fill_n(_barrierPoints, _barrierResolutionWidth, invertedBarrier? 1 : 0);
+
+	float itValue, floatingPixel, pixelPercentage;
+	int actualPixel, startPixel = 0, endPixel;
+	bool pair = true;
+	for (vector<float>::const_iterator it = points.begin(), end = points.end(); it != end; ++it)
+	{
+		itValue = (*it)*_spacing;
+		floatingPixel = itValue*_barrierInversePixelWidth;
+		actualPixel = floor(floatingPixel);
+		pixelPercentage = floatingPixel - floor(floatingPixel);
+
+		if (pair && pixelPercentage <= BARRIER_PIXEL_EPSILON_PERCENTAGE)
+		{
+			//previous pixel ends white 
+			endPixel = actualPixel - 1;
+
+			//paint white
+			fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? 0: 1);
+
+			//actual pixel starts black
+			startPixel = actualPixel;
+		} else if (pair && pixelPercentage > BARRIER_PIXEL_EPSILON_PERCENTAGE)
+		{
+			//actual pixel ends white
+			endPixel = actualPixel;
+
+			//paint white
+			fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? 0: 1);
+
+			//next pixel starts black
+			startPixel = actualPixel + 1;
+		} else if (!pair && pixelPercentage < BARRIER_PIXEL_EPSILON_PERCENTAGE)
+		{
+			//previous pixel ends black
+			endPixel = actualPixel - 1;
+
+			//paint black
+			//paintVerticalPixels(ofColor::black, startPixel, endPixel, _barrierImage);
+
+			//actual pixel starts white
+			startPixel = actualPixel;
+		} else if (!pair && pixelPercentage >= BARRIER_PIXEL_EPSILON_PERCENTAGE)
+		{
+			//actual pixel ends black
+			endPixel = actualPixel;
+
+			//paint black
+			//paintVerticalPixels(ofColor::black, startPixel, endPixel, _barrierImage);
+
+			//next pixel starts white
+			startPixel = actualPixel + 1;
+		}
+
+		pair = !pair;
+	}
+
+	if (startPixel < _barrierResolutionWidth)
+	{
+		//actual pixel ends white
+		endPixel = _barrierResolutionWidth - 1;
+
+		//paint white
+		fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? 0: 1);
+	}
+}
+
+void ParallaxBarrierRasterizer::updateScreenPoints(bool invertedBarrier)
+{
+	//points in the list delimit pixel zones for each eye view
+	//first zone corresponds to left eye view
+	const vector<float>& points = _model.getScreenPoints();
+
+	// update points
+	//initialize points array
+	fill_n(_screenPoints, _screenResolutionWidth, invertedBarrier? 1: -1);
+
+	float itValue, floatingPixel, pixelPercentage;
+	int actualPixel, startPixel = -1, endPixel;
+	bool pair = true;
+	for (vector<float>::const_iterator it = points.begin(), end = points.end(); it != end; ++it)
+	{
+		itValue = (*it)*_spacing;
+		floatingPixel = itValue*_screenInversePixelWidth;
+		actualPixel = floor(floatingPixel);
+		pixelPercentage = floatingPixel - floor(floatingPixel);
+
+		if (startPixel != -1) 
+		{
+			if (pixelPercentage >= SCREEN_PIXEL_EPSILON_PERCENTAGE && pixelPercentage <= (1 - SCREEN_PIXEL_EPSILON_PERCENTAGE)) 
+			{
+				//previous pixel ends left/right view
+				endPixel = actualPixel - 1;
+
+				//paint left/right view
+				if (pair)
+				{
+					//paint right view
+					fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? -1: 1);
+				} else
+				{
+					//paint left view
+					//paintVerticalPixels(leftEyeView, startPixel, endPixel, _screenImage);
+				}
+
+				//paint one black pixel
+				fill_n(&_screenPoints[actualPixel], 1, 0);
+
+				//next pixel starts left/right view
+				startPixel = actualPixel + 1;
+
+				errorRatio++;
+			} else if (pair && pixelPercentage < SCREEN_PIXEL_EPSILON_PERCENTAGE)
+			{
+				//previous pixel ends right view
+				endPixel = actualPixel - 1;
+
+				//paint right view
+				fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? -1: 1);
+
+				//actual pixel starts left view
+				startPixel = actualPixel;
+
+			} else if (!pair && pixelPercentage < SCREEN_PIXEL_EPSILON_PERCENTAGE)
+			{
+				//previous pixel ends left view
+				endPixel = actualPixel - 1;
+
+				//paint left view
+				//paintVerticalPixels(leftEyeView, startPixel, endPixel, _screenImage);
+
+				//actual pixel starts right view
+				startPixel = actualPixel;
+				
+			} else if (pair && pixelPercentage > (1 - SCREEN_PIXEL_EPSILON_PERCENTAGE))
+			{
+				//actual pixel ends right view
+				endPixel = actualPixel;
+
+				//paint right view
+				fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, invertedBarrier? -1: 1);
+
+				//next pixel starts left view
+				startPixel = actualPixel + 1;
+
+			} else if (!pair && pixelPercentage > (1 - SCREEN_PIXEL_EPSILON_PERCENTAGE))
+			{
+				//actual pixel ends left view
+				endPixel = actualPixel;
+
+				//paint left view
+				//paintVerticalPixels(leftEyeView, startPixel, endPixel, _screenImage);
+
+				//next pixel starts right view
+				startPixel = actualPixel + 1;
+
+			}
+		} else 
+		{
+			startPixel = actualPixel;
+		}
+
+		pair = !pair;
+	}
+
+	// end update points
+}
+
+void ParallaxBarrierRasterizer::updateFixedPoints(const vector<float> &points, float inversePixelWidth, vector<long long> &fixedPoints)
+{
+	// single rounding per boundary, in double so the result does not depend on float evaluation
+	double scale = (double) _spacing * inversePixelWidth * RASTERIZER_FIXED_POINT_ONE;
+	fixedPoints.resize(points.size());
+	for (size_t i = 0, size = points.size(); i < size; i++)
+	{
+		fixedPoints[i] = (long long) floor(points[i] * scale + 0.5);
+	}
+}
+
+void ParallaxBarrierRasterizer::updateBarrierPointsFixed(bool invertedBarrier)
+{
+	// same zones as updateBarrierPoints: 
+	// - pairs end the white zone, on the previous pixel when the boundary is within epsilon of its start
+	// - odd points start the next white zone, on the next pixel unless within epsilon
+	updateFixedPoints(_model.getBarrierPoints(), _barrierInversePixelWidth, _barrierFixedPoints);
+	const long long epsilon = (long long) (BARRIER_PIXEL_EPSILON_PERCENTAGE * RASTERIZER_FIXED_POINT_ONE);
+	signed char white = invertedBarrier? 0 : 1;
+
+	fill_n(_barrierPoints, _barrierResolutionWidth, invertedBarrier? 1 : 0);
+
+	int startPixel = 0;
+	bool pair = true;
+	for (vector<long long>::const_iterator it = _barrierFixedPoints.begin(), end = _barrierFixedPoints.end(); it != end; ++it)
+	{
+		int pixel = (int) (*it >> RASTERIZER_FIXED_POINT_BITS);
+		long long fraction = *it & RASTERIZER_FIXED_POINT_MASK;
+
+		if (pair)
+		{
+			int endPixel = pixel - (fraction <= epsilon);
+			fill_n(&_barrierPoints[startPixel], endPixel - startPixel + 1, white);
+			startPixel = endPixel + 1;
+		}
+		else
+		{
+			startPixel = pixel + (fraction >= epsilon);
+		}
+
+		pair = !pair;
+	}
+
+	if (startPixel < _barrierResolutionWidth)
+	{
+		fill_n(&_barrierPoints[startPixel], _barrierResolutionWidth - startPixel, white);
+	}
+}
+
+void ParallaxBarrierRasterizer::updateScreenPointsFixed(bool invertedBarrier)
+{
+	// same zones as updateScreenPoints, a boundary at fraction f of its pixel:
+	// - f < epsilon: the zone ends on the previous pixel
+	// - f > 1 - epsilon: the zone ends on the pixel
+	// - otherwise the pixel is a black guard pixel
+	// only right view zones (pairs) are painted, the map starts as left view
+	updateFixedPoints(_model.getScreenPoints(), _screenInversePixelWidth, _screenFixedPoints);
+	const long long epsilon = (long long) (SCREEN_PIXEL_EPSILON_PERCENTAGE * RASTERIZER_FIXED_POINT_ONE);
+	const long long oneMinusEpsilon = RASTERIZER_FIXED_POINT_ONE - epsilon;
+	signed char right = invertedBarrier? -1 : 1;
+
+	fill_n(_screenPoints, _screenResolutionWidth, invertedBarrier? 1: -1);
+
+	if (_screenFixedPoints.empty())
+		return;
+
+	int startPixel = (int) (_screenFixedPoints[0] >> RASTERIZER_FIXED_POINT_BITS);
+	bool pair = false;
+	for (vector<long long>::const_iterator it = _screenFixedPoints.begin() + 1, end = _screenFixedPoints.end(); it != end; ++it)
+	{
+		int pixel = (int) (*it >> RASTERIZER_FIXED_POINT_BITS);
+		long long fraction = *it & RASTERIZER_FIXED_POINT_MASK;
+		bool guard = fraction >= epsilon && fraction <= oneMinusEpsilon;
+
+		if (pair)
+		{
+			int endPixel = pixel - 1 + (fraction > oneMinusEpsilon);
+			fill_n(&_screenPoints[startPixel], endPixel - startPixel + 1, right);
+		}
+		if (guard)
+		{
+			_screenPoints[pixel] = 0;
+			errorRatio++;
+		}
+		startPixel = pixel + (fraction >= epsilon);
+
+		pair = !pair;
+	}
+}
+
+float ParallaxBarrierRasterizer::getWidth()
+{
+	return _width;
+}
+
+int ParallaxBarrierRasterizer::getScreenResolutionWidth()
+{
+	return _screenResolutionWidth;
+}
+
+int ParallaxBarrierRasterizer::getBarrierResolutionWidth()
+{
+	return _barrierResolutionWidth;
+}
+
+float ParallaxBarrierRasterizer::getSpacing()
+{
+	return _spacing;
+}
+
+const ofVec3f& ParallaxBarrierRasterizer::getPosition()
+{
+	return _position;
+}
+
+const ofVec3f& ParallaxBarrierRasterizer::getViewDirection()
+{
+	return _viewDirection;
+}
+
+const ofVec3f& ParallaxBarrierRasterizer::getUpDirection()
+{
+	return _upDirection;
+}
+
+void ParallaxBarrierRasterizer::setWidth(float width)
+{
+	this->_width = width;
+	_screenInversePixelWidth = _screenResolutionWidth/_width;
+	_barrierInversePixelWidth = _barrierResolutionWidth/_width;
+	_model.setWidth(_width*_modelScale);
+	updateModelTransformation();
+}
+
+void ParallaxBarrierRasterizer::setSpacing(float spacing)
+{
+	this->_spacing = spacing;
+	_modelScale = 1.f / _spacing;
+	_model.setWidth(_width*_modelScale);
+	updateModelTransformation();
+}
+
+void ParallaxBarrierRasterizer::setPosition(ofVec3f position)
+{
+	this->_position = position;
+	updateModelTransformation();
+}
+
+void ParallaxBarrierRasterizer::setViewDirection(ofVec3f viewDirection)
+{
+	this->_viewDirection = viewDirection;
+	updateModelTransformation();
+}
+
+void ParallaxBarrierRasterizer::setUpDirection(ofVec3f upDirection)
+{
+	this->_upDirection = upDirection;
+	updateModelTransformation();
+}
+
+const signed char* ParallaxBarrierRasterizer::getScreenPoints()
+{
+	return _screenPoints;
+}
+
+const signed char* ParallaxBarrierRasterizer::getBarrierPoints()
+{
+	return _barrierPoints;
+}
+
+const ofMatrix4x4& ParallaxBarrierRasterizer::getModelTransformation()
+{
+	return _modelTransformation;
+}
+
+ParallaxBarrierModel& ParallaxBarrierRasterizer::getModel()
+{
+	return _model;
+}
+
+int ParallaxBarrierRasterizer::getErrorRatio()
+{
+	return errorRatio;
+}
+
+unsigned long long ParallaxBarrierRasterizer::getModelTime()
+{
+	return _modelTime;
+}
+
+unsigned long long ParallaxBarrierRasterizer::getRasterizationTime()
+{
+	return _rasterizationTime;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ofVec3f.h"
+#include "ofMatrix4x4.h"
+
+#include "ParallaxBarrierModel.h"
+
+#define SCREEN_PIXEL_EPSILON_PERCENTAGE 0.01f//0.10f
+#define BARRIER_PIXEL_EPSILON_PERCENTAGE 0.01f//0.05f
+
+// fixed-point rasterization: boundaries in pixels with 32 fractional bits (32.32)
+#define RASTERIZER_FIXED_POINT_BITS 32
+#define RASTERIZER_FIXED_POINT_ONE (1LL << RASTERIZER_FIXED_POINT_BITS)
+#define RASTERIZER_FIXED_POINT_MASK (RASTERIZER_FIXED_POINT_ONE - 1)
+
+// ParallaxBarrierRasterizer turns eye positions into per column maps, 
+// it does not depend on OpenGL/OpenCL so it can run without a window:
+// - screen points: -1 left view, 1 right view, 0 black (one per screen column)
+// - barrier points: 1 transparent, 0 opaque (one per barrier column)
+// Column values use the cl_char layout expected by the kernels.
+// With fixed point enabled, boundaries are converted once to 32.32 pixel positions: pixel index 
+// and coverage are a shift and a mask, and the zone decisions are integer compares (same epsilons)
+class ParallaxBarrierRasterizer
+{
+public:
+	ParallaxBarrierRasterizer(float width, int screenResolutionWidth, int barrierResolutionWidth, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection);
+	ParallaxBarrierRasterizer(const ParallaxBarrierRasterizer &other);
+	virtual ~ParallaxBarrierRasterizer();
+
+	float getWidth();
+	int getScreenResolutionWidth();
+	int getBarrierResolutionWidth();
+	float getSpacing();
+	const ofVec3f& getPosition();
+	const ofVec3f& getViewDirection();
+	const ofVec3f& getUpDirection();
+	void setWidth(float width);
+	void setSpacing(float spacing);
+	void setPosition(ofVec3f position);
+	void setViewDirection(ofVec3f viewDirection);
+	void setUpDirection(ofVec3f upDirection);
+
+	// returns false when the model has no solution for the eye positions,
+	// 'phaseShift' shifts the zones by a fraction of a zone (see ParallaxBarrierModel)
+	bool update(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier = false, float phaseShift = 0.f);
+	// same as 'update' with eye positions already in model coordinates (see 'getModelTransformation')
+	bool update(ofVec2f const &modelLeftEyePosition, ofVec2f const &modelRightEyePosition, bool invertedBarrier = false, float phaseShift = 0.f);
+	// recomputes the column maps from the current model points ('update' does model and rasterization)
+	void rasterize(bool invertedBarrier = false);
+
+	bool isFixedPoint();
+	void setFixedPoint(bool fixedPoint);
+
+	// world to model coordinates, the 2D model position of a point is its transformed (x, z)
+	const ofMatrix4x4& getModelTransformation();
+
+	const signed char* getScreenPoints();
+	const signed char* getBarrierPoints();
+	ParallaxBarrierModel& getModel();
+
+	int getErrorRatio();
+	// durations of the last update stages in microseconds
+	unsigned long long getModelTime();
+	unsigned long long getRasterizationTime();
+
+private:
+	// copies own their maps, assignment is not supported
+	ParallaxBarrierRasterizer& operator=(const ParallaxBarrierRasterizer&);
+
+	float _width;
+	int _screenResolutionWidth;
+	int _barrierResolutionWidth;
+	float _spacing;
+	ofVec3f _position;
+	ofVec3f _viewDirection;
+	ofVec3f _upDirection;
+	float _barrierInversePixelWidth;
+	float _screenInversePixelWidth;
+
+	int errorRatio;
+	bool _fixedPoint;
+
+	unsigned long long _modelTime;
+	unsigned long long _rasterizationTime;
+
+	// model transformation
+	ofMatrix4x4 _modelTransformation;
+	float _modelScale;
+	ofVec2f _modelLeftEyePosition;
+	ofVec2f _modelRightEyePosition;
+
+	ParallaxBarrierModel _model;
+
+	// boundaries in 32.32 pixels, reused between updates
+	vector<long long> _screenFixedPoints;
+	vector<long long> _barrierFixedPoints;
+
+	signed char* _screenPoints;
+	signed char* _barrierPoints;
+
+	void updateModelTransformation();
+	void updateScreenPoints(bool invertedBarrier);
+	void updateBarrierPoints(bool invertedBarrier);
+	void updateFixedPoints(const vector<float> &points, float inversePixelWidth, vector<long long> &fixedPoints);
+	void updateScreenPointsFixed(bool invertedBarrier);
+	void updateBarrierPointsFixed(bool invertedBarrier);
+};
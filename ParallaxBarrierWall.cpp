@@ -0,0 +1,329 @@
+#include "ParallaxBarrierWall.h"
+
+#include "ofUtils.h"
+
+ParallaxBarrierWall* ParallaxBarrierWall::create(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, const vector<ofVec3f> &panelOffsets)
+{
+	if (panelOffsets.empty())
+	{
+		ofLogError("ParallaxBarrierWall") << "a wall needs at least one panel";
+		return NULL;
+	}
+
+	GLint maxTextureSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	if ((long long) panelOffsets.size() * max(screenResolutionWidth, barrierResolutionWidth) > maxTextureSize || max(screenResolutionHeight, barrierResolutionHeight) > maxTextureSize)
+	{
+		ofLogError("ParallaxBarrierWall") << panelOffsets.size() << " panels exceed the maximum texture size " << maxTextureSize;
+		return NULL;
+	}
+
+	return new ParallaxBarrierWall(width, height, screenResolutionWidth, screenResolutionHeight, barrierResolutionWidth, barrierResolutionHeight, spacing, position, viewDirection, upDirection, panelOffsets);
+}
+
+ParallaxBarrierWall::ParallaxBarrierWall(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, const vector<ofVec3f> &panelOffsets)
+{
+	_height = height;
+	_screenResolutionWidth = screenResolutionWidth;
+	_screenResolutionHeight = screenResolutionHeight;
+	_barrierResolutionWidth = barrierResolutionWidth;
+	_barrierResolutionHeight = barrierResolutionHeight;
+	_spacing = spacing;
+	_position = position;
+	_panelCount = panelOffsets.size();
+	_panelOffsets = panelOffsets;
+	_invertedBarrier = false;
+	_pointsTime = 0;
+	_kernelTime = 0;
+
+	// wall transformation, same rotation as the panel model transformations
+	ofMatrix4x4 modelScale, modelRotation, modelUpRotation, modelCenterTranslation;
+	modelScale.makeScaleMatrix(1.f/spacing, 1.f/spacing, 1.f/spacing);
+	modelRotation.makeRotationMatrix(viewDirection, ofVec3f(0,0,1));
+	modelUpRotation.makeRotationMatrix(modelRotation*upDirection, ofVec3f(0,1,0));
+	modelCenterTranslation.makeTranslationMatrix(-position);
+
+	_wallRotation = modelRotation * modelUpRotation;
+	_wallTransformation = modelCenterTranslation * _wallRotation * modelScale;
+
+	_panelUpdated = new bool[_panelCount];
+	for (int i = 0; i < _panelCount; i++)
+	{
+		// panel model transformations differ from the wall one by the panel offset and the half width centering
+		_panelModelOffsets.push_back((_panelOffsets[i] - ofVec3f(width * 0.5f, 0, 0)) / spacing);
+		_rasterizers.push_back(new ParallaxBarrierRasterizer(width, screenResolutionWidth, barrierResolutionWidth, spacing, getPanelPosition(i), viewDirection, upDirection));
+		_panelUpdated[i] = false;
+	}
+
+	// kernel loading and OpenCL kernel creation
+	_screenKernel = new OpenCLKernel("opencl/kernel/screenKernel.cl", "updateScreenPixels");
+	_barrierKernel = new OpenCLKernel("opencl/kernel/barrierKernel.cl", "updateBarrierPixels");
+
+	// wall textures initialization after OpenCL contexts are created
+	_barrierTexture.allocate(_panelCount * barrierResolutionWidth, barrierResolutionHeight, GL_RGBA);
+	_screenTexture.allocate(_panelCount * screenResolutionWidth, screenResolutionHeight, GL_RGBA);
+	_screenLeftTexture.allocate(_panelCount * screenResolutionWidth, screenResolutionHeight, GL_RGBA);
+	_screenRightTexture.allocate(_panelCount * screenResolutionWidth, screenResolutionHeight, GL_RGBA);
+
+	//OpenCL data initialization
+	_screenKernelLocalSize[0] = 16;
+	_screenKernelLocalSize[1] = 16;
+	_screenKernelGlobalSize[0] = _screenKernelLocalSize[0] * ceil( ((float) _panelCount * _screenResolutionWidth) / (float) _screenKernelLocalSize[0] );
+	_screenKernelGlobalSize[1] = _screenKernelLocalSize[1] * ceil( ((float) _screenResolutionHeight) / (float) _screenKernelLocalSize[1] );
+
+	_barrierKernelLocalSize[0] = 16;
+	_barrierKernelLocalSize[1] = 16;
+	_barrierKernelGlobalSize[0] = _barrierKernelLocalSize[0] * ceil( ((float) _panelCount * _barrierResolutionWidth) / (float) _barrierKernelLocalSize[0] );
+	_barrierKernelGlobalSize[1] = _barrierKernelLocalSize[1] * ceil( ((float) _barrierResolutionHeight) / (float) _barrierKernelLocalSize[1] );
+
+	_screenPoints = new cl_char[_panelCount * screenResolutionWidth];
+	_barrierPoints = new cl_char[_panelCount * barrierResolutionWidth];
+	fill_n(_screenPoints, _panelCount * screenResolutionWidth, 0);
+	fill_n(_barrierPoints, _panelCount * barrierResolutionWidth, 0);
+
+	_screenPointsBuffer = new OpenCLBuffer(_screenPoints, _panelCount * _screenResolutionWidth * sizeof(cl_char));
+	_screenKernelReadBuffers.push_back(_screenPointsBuffer);
+
+	_barrierPointsBuffer = new OpenCLBuffer(_barrierPoints, _panelCount * _barrierResolutionWidth * sizeof(cl_char));
+	_barrierKernelReadBuffers.push_back(_barrierPointsBuffer);
+
+	_leftImageTexture = new OpenCLTexture(_screenLeftTexture.getTextureData().textureID, _screenLeftTexture.getTextureData().textureTarget);
+	_screenKernelReadTextures.push_back(_leftImageTexture);
+	_rightImageTexture = new OpenCLTexture(_screenRightTexture.getTextureData().textureID, _screenRightTexture.getTextureData().textureTarget);
+	_screenKernelReadTextures.push_back(_rightImageTexture);
+
+	_screenImageTexture = new OpenCLTexture(_screenTexture.getTextureData().textureID, _screenTexture.getTextureData().textureTarget);
+	_screenKernelWriteTextures.push_back(_screenImageTexture);
+
+	_barrierImageTexture = new OpenCLTexture(_barrierTexture.getTextureData().textureID, _barrierTexture.getTextureData().textureTarget);
+	_barrierKernelWriteTextures.push_back(_barrierImageTexture);
+
+	_screenKernel->defineArguments(NULL, &_screenKernelReadBuffers, NULL, &_screenKernelReadTextures, &_screenKernelWriteTextures);
+	_barrierKernel->defineArguments(NULL, &_barrierKernelReadBuffers, NULL, NULL, &_barrierKernelWriteTextures);
+
+	// panel workers
+	_workGeneration = 0;
+	_busyWorkers = 0;
+	_stopWorkers = false;
+	_nextPanel = _panelCount;
+	int workerCount = min(_panelCount, (int) max(thread::hardware_concurrency(), 1u)) - 1;
+	for (int i = 0; i < workerCount; i++)
+	{
+		_workers.push_back(thread(&ParallaxBarrierWall::runWorker, this));
+	}
+}
+
+ParallaxBarrierWall::~ParallaxBarrierWall()
+{
+	{
+		lock_guard<mutex> lock(_workMutex);
+		_stopWorkers = true;
+	}
+	_workCondition.notify_all();
+	for (vector<thread>::iterator it = _workers.begin(), end = _workers.end(); it != end; ++it)
+	{
+		it->join();
+	}
+
+	for (vector<ParallaxBarrierRasterizer*>::iterator it = _rasterizers.begin(), end = _rasterizers.end(); it != end; ++it)
+	{
+		delete *it;
+	}
+	delete[] _panelUpdated;
+
+	delete _screenKernel;
+	delete _barrierKernel;
+	delete[] _screenPoints;
+	delete[] _barrierPoints;
+
+	delete _screenPointsBuffer;
+	delete _barrierPointsBuffer;
+	delete _leftImageTexture;
+	delete _rightImageTexture;
+	delete _screenImageTexture;
+	delete _barrierImageTexture;
+}
+
+void ParallaxBarrierWall::update(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier)
+{
+	updatePoints(leftEyePosition, rightEyePosition, invertedBarrier);
+	updateImages();
+}
+
+void ParallaxBarrierWall::updatePoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier)
+{
+	unsigned long long startTime = ofGetElapsedTimeMicros();
+
+	//eye transformation is shared by all panels
+	_wallLeftEyePosition = leftEyePosition * _wallTransformation;
+	_wallRightEyePosition = rightEyePosition * _wallTransformation;
+	_invertedBarrier = invertedBarrier;
+
+	//wake up the workers and update panels until none is left
+	{
+		lock_guard<mutex> lock(_workMutex);
+		_nextPanel = 0;
+		_busyWorkers = _workers.size();
+		_workGeneration++;
+	}
+	_workCondition.notify_all();
+
+	updatePanels();
+
+	unique_lock<mutex> lock(_workMutex);
+	_doneCondition.wait(lock, [this] { return _busyWorkers == 0; });
+
+	_pointsTime = ofGetElapsedTimeMicros() - startTime;
+}
+
+void ParallaxBarrierWall::runWorker()
+{
+	unsigned long generation = 0;
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(_workMutex);
+			_workCondition.wait(lock, [this, generation] { return _stopWorkers || _workGeneration != generation; });
+			if (_stopWorkers)
+				return;
+			generation = _workGeneration;
+		}
+
+		updatePanels();
+
+		{
+			lock_guard<mutex> lock(_workMutex);
+			_busyWorkers--;
+		}
+		_doneCondition.notify_one();
+	}
+}
+
+void ParallaxBarrierWall::updatePanels()
+{
+	for (int panel = _nextPanel++; panel < _panelCount; panel = _nextPanel++)
+	{
+		const ofVec3f &modelOffset = _panelModelOffsets[panel];
+		ofVec2f modelLeftEyePosition(_wallLeftEyePosition.x - modelOffset.x, _wallLeftEyePosition.z - modelOffset.z);
+		ofVec2f modelRightEyePosition(_wallRightEyePosition.x - modelOffset.x, _wallRightEyePosition.z - modelOffset.z);
+
+		ParallaxBarrierRasterizer &rasterizer = *_rasterizers[panel];
+		_panelUpdated[panel] = rasterizer.update(modelLeftEyePosition, modelRightEyePosition, _invertedBarrier);
+
+		//kernel buffers are bound to these arrays, each panel writes its own range
+		copy(rasterizer.getScreenPoints(), rasterizer.getScreenPoints() + _screenResolutionWidth, _screenPoints + panel * _screenResolutionWidth);
+		copy(rasterizer.getBarrierPoints(), rasterizer.getBarrierPoints() + _barrierResolutionWidth, _barrierPoints + panel * _barrierResolutionWidth);
+	}
+}
+
+void ParallaxBarrierWall::updateImages()
+{
+	unsigned long long startTime = ofGetElapsedTimeMicros();
+
+	//update barrier and screen textures of all panels in opencl
+	_barrierKernel->execute(2, _barrierKernelGlobalSize, _barrierKernelLocalSize);
+	_screenKernel->execute(2, _screenKernelGlobalSize, _screenKernelLocalSize);
+
+	_kernelTime = ofGetElapsedTimeMicros() - startTime;
+}
+
+int ParallaxBarrierWall::getPanelCount()
+{
+	return _panelCount;
+}
+
+const ofVec3f& ParallaxBarrierWall::getPanelOffset(int panel)
+{
+	return _panelOffsets[panel];
+}
+
+ofVec3f ParallaxBarrierWall::getPanelPosition(int panel)
+{
+	//rotations are orthonormal, the transposed rotation takes wall directions to world directions
+	return _position + _wallRotation * _panelOffsets[panel];
+}
+
+ofRectangle ParallaxBarrierWall::getScreenTile(int panel)
+{
+	return ofRectangle(panel * _screenResolutionWidth, 0, _screenResolutionWidth, _screenResolutionHeight);
+}
+
+ofRectangle ParallaxBarrierWall::getBarrierTile(int panel)
+{
+	return ofRectangle(panel * _barrierResolutionWidth, 0, _barrierResolutionWidth, _barrierResolutionHeight);
+}
+
+float ParallaxBarrierWall::getWidth()
+{
+	return _rasterizers.empty()? 0 : _rasterizers[0]->getWidth();
+}
+
+float ParallaxBarrierWall::getHeight()
+{
+	return _height;
+}
+
+int ParallaxBarrierWall::getScreenResolutionWidth()
+{
+	return _screenResolutionWidth;
+}
+
+int ParallaxBarrierWall::getScreenResolutionHeight()
+{
+	return _screenResolutionHeight;
+}
+
+int ParallaxBarrierWall::getBarrierResolutionWidth()
+{
+	return _barrierResolutionWidth;
+}
+
+int ParallaxBarrierWall::getBarrierResolutionHeight()
+{
+	return _barrierResolutionHeight;
+}
+
+float ParallaxBarrierWall::getSpacing()
+{
+	return _spacing;
+}
+
+bool ParallaxBarrierWall::isPanelUpdated(int panel)
+{
+	return _panelUpdated[panel];
+}
+
+ParallaxBarrierRasterizer& ParallaxBarrierWall::getRasterizer(int panel)
+{
+	return *_rasterizers[panel];
+}
+
+ofTexture& ParallaxBarrierWall::getScreenTexture()
+{
+	return _screenTexture;
+}
+
+ofTexture& ParallaxBarrierWall::getBarrierTexture()
+{
+	return _barrierTexture;
+}
+
+ofTexture& ParallaxBarrierWall::getScreenLeftTexture()
+{
+	return _screenLeftTexture;
+}
+
+ofTexture& ParallaxBarrierWall::getScreenRightTexture()
+{
+	return _screenRightTexture;
+}
+
+unsigned long long ParallaxBarrierWall::getPointsTime()
+{
+	return _pointsTime;
+}
+
+unsigned long long ParallaxBarrierWall::getKernelTime()
+{
+	return _kernelTime;
+}
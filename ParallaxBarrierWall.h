@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ofVec3f.h"
+#include "ofTexture.h"
+#include "ofRectangle.h"
+
+#include "ParallaxBarrierRasterizer.h"
+#include "opencl/OpenCLKernel.h"
+
+// ParallaxBarrierWall drives several barrier panels tiled into a video wall:
+// - panels share size, resolutions, spacing and orientation, each one is placed by an offset 
+//   from the wall position in wall coordinates (x: model x axis, y: up direction, z: view direction)
+// - eye positions are transformed to wall coordinates once per update, 
+//   panel model positions are a translation of them
+// - panel column maps are computed in parallel, one panel at a time per worker thread
+// - images of all panels are tiles of wall images (panel i covers the columns 
+//   [i * resolution width, (i + 1) * resolution width)), so each kernel runs once for the whole wall.
+//   Wall images must fit in GL_MAX_TEXTURE_SIZE, walls are created by 'create' which checks it
+class ParallaxBarrierWall
+{
+public:
+	// NULL when there are no panels or the wall images exceed GL_MAX_TEXTURE_SIZE, needs the GL context
+	static ParallaxBarrierWall* create(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, const vector<ofVec3f> &panelOffsets);
+	virtual ~ParallaxBarrierWall();
+
+	int getPanelCount();
+	const ofVec3f& getPanelOffset(int panel);
+	// world position of the panel center
+	ofVec3f getPanelPosition(int panel);
+	// tiles of the panel in the wall screen (left, right and screen images) and barrier images
+	ofRectangle getScreenTile(int panel);
+	ofRectangle getBarrierTile(int panel);
+
+	float getWidth();
+	float getHeight();
+	int getScreenResolutionWidth();
+	int getScreenResolutionHeight();
+	int getBarrierResolutionWidth();
+	int getBarrierResolutionHeight();
+	float getSpacing();
+
+	void update(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier = false);
+	// 'update' is equivalent to 'updatePoints' followed by 'updateImages'
+	void updatePoints(ofVec3f const &leftEyePosition, ofVec3f const &rightEyePosition, bool invertedBarrier = false);
+	void updateImages();
+
+	// false when the model of the panel had no solution in the last 'updatePoints' call
+	bool isPanelUpdated(int panel);
+	ParallaxBarrierRasterizer& getRasterizer(int panel);
+
+	ofTexture& getScreenTexture();
+	ofTexture& getBarrierTexture();
+
+	ofTexture& getScreenLeftTexture();
+	ofTexture& getScreenRightTexture();
+
+	// durations of the last update stages in microseconds, 
+	// points time covers the model and rasterization of all panels
+	unsigned long long getPointsTime();
+	unsigned long long getKernelTime();
+
+private:
+	ParallaxBarrierWall(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, const vector<ofVec3f> &panelOffsets);
+	ParallaxBarrierWall(const ParallaxBarrierWall&);
+	ParallaxBarrierWall& operator=(const ParallaxBarrierWall&);
+
+	float _height;
+	int _screenResolutionWidth;
+	int _screenResolutionHeight;
+	int _barrierResolutionWidth;
+	int _barrierResolutionHeight;
+	float _spacing;
+	ofVec3f _position;
+
+	int _panelCount;
+	vector<ofVec3f> _panelOffsets;
+	// panel model position = wall model position - panel model offset
+	vector<ofVec3f> _panelModelOffsets;
+	vector<ParallaxBarrierRasterizer*> _rasterizers;
+	bool* _panelUpdated;
+
+	// world to wall model coordinates (wall coordinates scaled by the model scale)
+	ofMatrix4x4 _wallTransformation;
+	ofMatrix4x4 _wallRotation;
+	ofVec3f _wallLeftEyePosition;
+	ofVec3f _wallRightEyePosition;
+	bool _invertedBarrier;
+
+	unsigned long long _pointsTime;
+	unsigned long long _kernelTime;
+
+	// panel workers, the calling thread also updates panels
+	vector<thread> _workers;
+	mutex _workMutex;
+	condition_variable _workCondition;
+	condition_variable _doneCondition;
+	unsigned long _workGeneration;
+	int _busyWorkers;
+	bool _stopWorkers;
+	atomic<int> _nextPanel;
+
+	ofTexture _barrierTexture;
+	ofTexture _screenTexture;
+	ofTexture _screenLeftTexture;
+	ofTexture _screenRightTexture;
+
+	OpenCLKernel * _screenKernel;
+	OpenCLKernel * _barrierKernel;
+
+	size_t _screenKernelLocalSize[2];
+	size_t _screenKernelGlobalSize[2];
+	size_t _barrierKernelLocalSize[2];
+	size_t _barrierKernelGlobalSize[2];
+
+	OpenCLBuffer *_screenPointsBuffer;
+	OpenCLTexture *_leftImageTexture, *_rightImageTexture, *_screenImageTexture;
+
+	OpenCLBuffer *_barrierPointsBuffer;
+	OpenCLTexture *_barrierImageTexture;
+
+	list<OpenCLBuffer*> _screenKernelReadBuffers;
+	list<OpenCLTexture*> _screenKernelReadTextures;
+	list<OpenCLTexture*> _screenKernelWriteTextures;
+
+	list<OpenCLBuffer*> _barrierKernelReadBuffers;
+	list<OpenCLTexture*> _barrierKernelWriteTextures;
+
+	// column maps of all panels, one after the other
+	cl_char* _screenPoints;
+	cl_char* _barrierPoints;
+
+	void runWorker();
+	void updatePanels();
+};
@@ -0,0 +1,191 @@
+#include "ParallaxBarrierWallApp.h"
+
+WallBarrierWindow::WallBarrierWindow(): parallaxBarrierWall(NULL), verticalSyncApplied(false)
+{
+}
+
+//--------------------------------------------------------------
+WallBarrierWindow::~WallBarrierWindow()
+{
+}
+
+//--------------------------------------------------------------
+void WallBarrierWindow::draw()
+{
+	//applied while this window's context is the current one
+	if (!verticalSyncApplied)
+	{
+		ofSetVerticalSync(false);
+		verticalSyncApplied = true;
+	}
+
+	if (parallaxBarrierWall != NULL)
+	{
+		parallaxBarrierWall->getBarrierTexture().draw(0, 0);
+	}
+}
+
+//--------------------------------------------------------------
+void WallBarrierWindow::keyReleased(int key, ofxFenster* window)
+{
+	if(key=='f')
+		window->toggleFullscreen();
+}
+
+ParallaxBarrierWallApp::ParallaxBarrierWallApp(): invertBarrier(false), eyeTracker(NULL), parallaxBarrierWall(NULL), barrierWindow(NULL), frameBufferObject(0), frameBufferDepthTexture(0)
+{
+}
+
+ParallaxBarrierWallApp::~ParallaxBarrierWallApp()
+{
+	if (eyeTracker != NULL)
+	{
+		eyeTracker->stop();
+		delete eyeTracker;
+	}
+	delete parallaxBarrierWall;
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierWallApp::setup()
+{
+	//ParallaxBarrierWall app setup
+	setupApp();
+
+	if (parallaxBarrierWall != NULL)
+	{
+		glGenTextures(1, &frameBufferDepthTexture);
+		glBindTexture(GL_TEXTURE_2D, frameBufferDepthTexture);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, viewport.width, viewport.height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		//views of all panels are drawn at once into the wall left/right textures
+		glGenFramebuffers(1, &frameBufferObject);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, frameBufferDepthTexture, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, parallaxBarrierWall->getScreenLeftTexture().getTextureData().textureID, 0);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, parallaxBarrierWall->getScreenRightTexture().getTextureData().textureID, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	ofBackground(0,0,0);
+
+	//Barrier window is displayed in second monitor if there is one available
+	ofxDisplayList displays = ofxDisplayManager::get()->getDisplays();
+	ofxDisplay* disp = displays[0];
+	if(displays.size() > 1)
+		disp = displays[1];
+	ofxFensterManager::get()->setActiveDisplay(disp);
+
+	//Create barrier window
+	WallBarrierWindow *barrierWindowListener = new WallBarrierWindow();
+	barrierWindow = ofxFensterManager::get()->createFenster(400, 0, 400, 400, OF_WINDOW);
+	barrierWindow->addListener(barrierWindowListener);
+	barrierWindow->setWindowTitle("Barrier wall");
+	barrierWindow->setBackgroundColor(0, 0, 0);
+
+	barrierWindowListener->parallaxBarrierWall = parallaxBarrierWall;
+
+	if (eyeTracker != NULL)
+	{
+		eyeTracker->start();
+	}
+}
+
+//--------------------------------------------------------------
+bool ParallaxBarrierWallApp::initializeParallaxBarrierWall(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, const vector<ofVec3f> &panelOffsets)
+{
+	parallaxBarrierWall = ParallaxBarrierWall::create(width, height, screenResolutionWidth, screenResolutionHeight, barrierResolutionWidth, barrierResolutionHeight, spacing, position, viewDirection, upDirection, panelOffsets);
+	if (parallaxBarrierWall == NULL)
+		return false;
+
+	viewport = ofRectangle(0, 0, parallaxBarrierWall->getPanelCount() * screenResolutionWidth, screenResolutionHeight);
+	return true;
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierWallApp::draw()
+{
+	if (parallaxBarrierWall == NULL)
+		return;
+
+	//newest tracker sample, never waits for the tracker
+	EyeTrackerSample eyeTrackerSample;
+	if (eyeTracker != NULL && eyeTracker->getLatestSample(eyeTrackerSample))
+	{
+		leftEyePosition = eyeTrackerSample.leftEyePosition;
+		rightEyePosition = eyeTrackerSample.rightEyePosition;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObject);
+
+	ofPushMatrix();
+	if (ofGetWindowHeight() > viewport.height)
+	{
+		ofTranslate(0, ofGetWindowHeight() - viewport.height);
+	}
+
+	//draw left image and load into left wall texture
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	ofPushView();
+	glViewport(0, 0, viewport.width, viewport.height);
+	drawLeft();
+	ofPopView();
+
+	//draw right image and load into right wall texture
+	glDrawBuffer(GL_COLOR_ATTACHMENT1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	ofPushView();
+	glViewport(0, 0, viewport.width, viewport.height);
+	drawRight();
+	ofPopView();
+
+	ofPopMatrix();
+
+	//disable fbo and use screen
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//column maps of all panels, then one kernel pass for the whole wall
+	parallaxBarrierWall->update(leftEyePosition, rightEyePosition, invertBarrier);
+
+	ofSetColor(ofColor::white);
+
+	//draw wall screen texture
+	ofPushMatrix();
+	ofScale(1,-1);
+	ofTranslate(0, -min((float) ofGetWindowHeight(), viewport.height));
+	ofDisableLighting();
+	parallaxBarrierWall->getScreenTexture().draw(0, 0);
+	ofPopMatrix();
+
+	string msg = string("");
+	msg += "\nfps: " + ofToString(ofGetFrameRate(), 2);
+	msg += "\npanels: " + ofToString(parallaxBarrierWall->getPanelCount());
+	msg += "\npoints: " + ofToString(parallaxBarrierWall->getPointsTime()) + " us";
+	msg += "\nkernel: " + ofToString(parallaxBarrierWall->getKernelTime()) + " us";
+	ofDrawBitmapStringHighlight(msg, 10, 20);
+}
+
+//--------------------------------------------------------------
+const ofRectangle& ParallaxBarrierWallApp::getViewport()
+{
+	return viewport;
+}
+
+//--------------------------------------------------------------
+void ParallaxBarrierWallApp::keyReleased(int key)
+{
+	if(key=='f')
+		ofxFensterManager::get()->getPrimaryWindow()->toggleFullscreen();
+	if(key=='b')
+		invertBarrier = !invertBarrier;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxFensterManager.h"
+#include "ParallaxBarrierWall.h"
+#include "EyeTracker.h"
+
+class WallBarrierWindow: public ofxFensterListener {
+public:
+	WallBarrierWindow();
+	~WallBarrierWindow();
+	void draw();
+	void keyReleased(int key, ofxFenster* window);
+
+	ParallaxBarrierWall* parallaxBarrierWall;
+
+private:
+	bool verticalSyncApplied;
+};
+
+// ParallaxBarrierWallApp runs a video wall (see ParallaxBarrierWall) the way ParallaxBarrierApp runs
+// a single panel: apps draw the left/right views of the whole wall, the screen window shows the wall 
+// screen image (panels side by side, one window spanning the panel displays) and a second window
+// shows the wall barrier image
+class ParallaxBarrierWallApp : public ofBaseApp {
+
+public:
+	ParallaxBarrierWallApp();
+	~ParallaxBarrierWallApp();
+
+	// ParallaxBarrierWall apps only need to implement setupApp
+	void setup();
+	virtual void setupApp() {};
+	// 'initializeParallaxBarrierWall' method must be called from 'setupApp' method, 
+	// false when the wall could not be created (see ParallaxBarrierWall::create)
+	bool initializeParallaxBarrierWall(float width, float height, int screenResolutionWidth, int screenResolutionHeight, int barrierResolutionWidth, int barrierResolutionHeight, float spacing, ofVec3f const &position, ofVec3f const &viewDirection, ofVec3f const &upDirection, const vector<ofVec3f> &panelOffsets);
+
+	// ParallaxBarrierWall apps only need to implement drawLeft and drawRight, 
+	// drawing covers the whole wall (see getViewport and ParallaxBarrierWall::getScreenTile)
+	void draw();
+	virtual void drawLeft() {};
+	virtual void drawRight() {};
+
+	const ofRectangle& getViewport();
+
+	void keyReleased(int key);
+
+protected:
+	// Eye positions need to be 
+	// updated in app 'update' method,
+	// unless an eye tracker is set
+	ofVec3f leftEyePosition;
+	ofVec3f rightEyePosition;
+	bool invertBarrier;
+
+	// when set (in 'setupApp'), the tracker is started by 'setup' and owned by the app.
+	// Its newest sample sets the eye positions of every frame
+	EyeTracker* eyeTracker;
+
+	ParallaxBarrierWall* parallaxBarrierWall;
+
+	ofRectangle viewport;
+
+private:
+	ofxFenster* barrierWindow;
+
+	GLuint frameBufferObject;
+	GLuint frameBufferDepthTexture;
+};
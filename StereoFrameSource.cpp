@@ -0,0 +1,294 @@
+#include "StereoFrameSource.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+StereoFrameSource::StereoFrameSource(): width(0), height(0), layout(STEREO_FRAME_SIDE_BY_SIDE), frameRate(0), loop(true), frameCount(0), frameSize(0), 
+	persistentBuffers(false), buffersInitialized(false), nextSlot(0), startTime(0), dueSequence(0), frame(-1), lateFrames(0), droppedFrames(0)
+{
+	for (int i = 0; i < STEREO_FRAME_SOURCE_RING_SIZE; i++)
+	{
+		slots[i].buffer = 0;
+		slots[i].data = NULL;
+		slots[i].fence = 0;
+		slots[i].sequence = 0;
+		slots[i].state.store(SLOT_FREE);
+	}
+}
+
+StereoFrameSource::~StereoFrameSource()
+{
+	close();
+}
+
+bool StereoFrameSource::open(const string &fileName, int width, int height, int layout, float frameRate, bool loop)
+{
+	close();
+
+	if (width <= 0 || height <= 0 || frameRate <= 0 || !file.open(fileName))
+	{
+		ofLogError("StereoFrameSource") << "could not open '" << fileName << "'";
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->layout = layout;
+	this->frameRate = frameRate;
+	this->loop = loop;
+	frameSize = (size_t) width * height * 4 * 2;
+	frameCount = (int) (file.getSize() / frameSize);
+	if (frameCount == 0)
+	{
+		ofLogError("StereoFrameSource") << "'" << fileName << "' holds no " << width << "x" << height << " stereo frame";
+		file.close();
+		return false;
+	}
+	if (file.getSize() % frameSize != 0)
+	{
+		ofLogWarning("StereoFrameSource") << "'" << fileName << "' ends with a partial frame";
+	}
+
+	frame = -1;
+	lateFrames = 0;
+	droppedFrames = 0;
+	return true;
+}
+
+void StereoFrameSource::close()
+{
+	waitForThread(true);
+
+	for (int i = 0; i < STEREO_FRAME_SOURCE_RING_SIZE; i++)
+	{
+		Slot &slot = slots[i];
+		if (slot.fence != 0)
+			glDeleteSync(slot.fence);
+		if (slot.buffer != 0)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+			if (slot.data != NULL)
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &slot.buffer);
+		}
+		slot.buffer = 0;
+		slot.data = NULL;
+		slot.fence = 0;
+		slot.state.store(SLOT_FREE);
+	}
+
+	buffersInitialized = false;
+	persistentBuffers = false;
+	nextSlot = 0;
+	fallbackPixels.clear();
+	file.close();
+	frameCount = 0;
+}
+
+bool StereoFrameSource::isOpen()
+{
+	return frameCount > 0;
+}
+
+int StereoFrameSource::getFrameCount()
+{
+	return frameCount;
+}
+
+int StereoFrameSource::getFrame()
+{
+	return frame;
+}
+
+unsigned long StereoFrameSource::getLateFrames()
+{
+	return lateFrames;
+}
+
+unsigned long StereoFrameSource::getDroppedFrames()
+{
+	return droppedFrames;
+}
+
+bool StereoFrameSource::initializeBuffers()
+{
+	buffersInitialized = true;
+
+	persistentBuffers = glewIsSupported("GL_ARB_buffer_storage");
+	for (int i = 0; i < STEREO_FRAME_SOURCE_RING_SIZE && persistentBuffers; i++)
+	{
+		//written by the prefetch thread while mapped, coherent so no flush is needed before the upload
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &slots[i].buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[i].buffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, frameSize, NULL, flags);
+		slots[i].data = (unsigned char*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize, flags);
+		persistentBuffers = slots[i].data != NULL;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!persistentBuffers)
+	{
+		ofLogWarning("StereoFrameSource") << "no persistent pixel buffers, frames are copied on the render thread";
+		fallbackPixels.resize(frameSize);
+		return false;
+	}
+
+	return true;
+}
+
+void StereoFrameSource::copyFrame(int frame, unsigned char* destination)
+{
+	//rows are flipped to the bottom up order of the view textures, packed frames flip each view on its own
+	const unsigned char* source = file.getData() + (size_t) frame * frameSize;
+	int views = layout == STEREO_FRAME_PACKED? 2 : 1;
+	size_t viewSize = frameSize / views;
+	size_t rowSize = viewSize / height;
+	for (int view = 0; view < views; view++)
+	{
+		for (int row = 0; row < height; row++)
+		{
+			memcpy(destination + view * viewSize + (height - 1 - row) * rowSize, source + view * viewSize + row * rowSize, rowSize);
+		}
+	}
+}
+
+void StereoFrameSource::uploadFrame(ParallaxBarrier &parallaxBarrier, const unsigned char* pixels)
+{
+	//'pixels' is an offset into the bound pixel buffer, or client memory without one
+	const unsigned char* rightPixels = pixels + (layout == STEREO_FRAME_PACKED? frameSize / 2 : (size_t) width * 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, layout == STEREO_FRAME_PACKED? width : width * 2);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (parallaxBarrier.isLayeredStereo())
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, parallaxBarrier.getScreenStereoTexture());
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 1, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rightPixels);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	else
+	{
+		ofTextureData &leftTexture = parallaxBarrier.getScreenLeftTexture().getTextureData();
+		ofTextureData &rightTexture = parallaxBarrier.getScreenRightTexture().getTextureData();
+		glBindTexture(leftTexture.textureTarget, leftTexture.textureID);
+		glTexSubImage2D(leftTexture.textureTarget, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glBindTexture(rightTexture.textureTarget, rightTexture.textureID);
+		glTexSubImage2D(rightTexture.textureTarget, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rightPixels);
+		glBindTexture(rightTexture.textureTarget, 0);
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+bool StereoFrameSource::update(ParallaxBarrier &parallaxBarrier)
+{
+	if (!isOpen())
+		return false;
+
+	if (!buffersInitialized)
+	{
+		if (parallaxBarrier.getEyeResolutionWidth() != width || parallaxBarrier.getScreenResolutionHeight() != height)
+		{
+			ofLogError("StereoFrameSource") << width << "x" << height << " frames do not match the " << parallaxBarrier.getEyeResolutionWidth() << "x" << parallaxBarrier.getScreenResolutionHeight() << " views";
+			close();
+			return false;
+		}
+
+		startTime = ofGetElapsedTimeMicros();
+		if (initializeBuffers())
+			startThread(false, false);
+	}
+
+	unsigned long long sequence = (unsigned long long) ((ofGetElapsedTimeMicros() - startTime) * 0.000001 * frameRate);
+	if (!loop)
+		sequence = min(sequence, (unsigned long long) frameCount - 1);
+	dueSequence.store(sequence, memory_order_relaxed);
+
+	if (!persistentBuffers)
+	{
+		if ((int) (sequence % frameCount) == frame)
+			return false;
+
+		frame = (int) (sequence % frameCount);
+		copyFrame(frame, &fallbackPixels[0]);
+		uploadFrame(parallaxBarrier, &fallbackPixels[0]);
+		return true;
+	}
+
+	//buffers the GPU finished reading go back to the prefetcher
+	for (int i = 0; i < STEREO_FRAME_SOURCE_RING_SIZE; i++)
+	{
+		Slot &slot = slots[i];
+		if (slot.state.load(memory_order_relaxed) == SLOT_UPLOADED)
+		{
+			GLenum result = glClientWaitSync(slot.fence, 0, 0);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+			{
+				glDeleteSync(slot.fence);
+				slot.fence = 0;
+				slot.state.store(SLOT_FREE, memory_order_release);
+			}
+		}
+	}
+
+	//newest prefetched frame that is due, older due frames are passed over
+	int uploadSlot = -1;
+	while (slots[nextSlot].state.load(memory_order_acquire) == SLOT_READY && slots[nextSlot].sequence <= sequence)
+	{
+		if (uploadSlot >= 0)
+		{
+			slots[uploadSlot].state.store(SLOT_FREE, memory_order_release);
+			droppedFrames++;
+		}
+		uploadSlot = nextSlot;
+		nextSlot = (nextSlot + 1) % STEREO_FRAME_SOURCE_RING_SIZE;
+	}
+
+	if (uploadSlot < 0)
+	{
+		if (frame < 0 || (int) (sequence % frameCount) != frame)
+			lateFrames++;
+		return false;
+	}
+
+	Slot &slot = slots[uploadSlot];
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+	uploadFrame(parallaxBarrier, NULL);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.state.store(SLOT_UPLOADED, memory_order_relaxed);
+
+	frame = (int) (slot.sequence % frameCount);
+	return true;
+}
+
+void StereoFrameSource::threadedFunction()
+{
+	unsigned long long sequence = 0;
+	int slotIndex = 0;
+
+	while (isThreadRunning())
+	{
+		Slot &slot = slots[slotIndex];
+		if (slot.state.load(memory_order_acquire) != SLOT_FREE || (!loop && sequence >= (unsigned long long) frameCount))
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+
+		//frames already due are not worth copying
+		sequence = max(sequence, dueSequence.load(memory_order_relaxed));
+		if (!loop)
+			sequence = min(sequence, (unsigned long long) frameCount - 1);
+
+		copyFrame((int) (sequence % frameCount), slot.data);
+		slot.sequence = sequence;
+		slot.state.store(SLOT_READY, memory_order_release);
+
+		slotIndex = (slotIndex + 1) % STEREO_FRAME_SOURCE_RING_SIZE;
+		sequence++;
+	}
+}
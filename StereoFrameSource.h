@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <atomic>
+
+#include "MemoryMappedFile.h"
+#include "ParallaxBarrier.h"
+
+// raw stereo frame layouts, RGBA8 pixels with rows top down
+// - SIDE_BY_SIDE: frames are twice the view width, left view on the left half
+// - PACKED: the left view followed by the right view (frame packing without gap)
+#define STEREO_FRAME_SIDE_BY_SIDE 0
+#define STEREO_FRAME_PACKED 1
+
+// frames prefetched ahead of the render thread
+#define STEREO_FRAME_SOURCE_RING_SIZE 3
+
+using namespace std;
+
+// StereoFrameSource plays a raw stereo clip (a memory mapped file of headerless frames) into
+// the view textures of a ParallaxBarrier:
+// - a prefetch thread copies the next frames from the mapping into a ring of persistently mapped
+//   pixel buffers (GL_ARB_buffer_storage), flipping rows to the bottom up texture order
+// - 'update' (render thread) uploads the newest due frame from its pixel buffer with
+//   glTexSubImage, a DMA transfer without CPU copies, and fences the buffer until the GPU read it
+// - frames are due at the clip frame rate from the first 'update', frames the prefetcher
+//   did not deliver in time are counted as late, frames passed over as dropped
+// Without GL_ARB_buffer_storage frames are copied and uploaded on the render thread.
+// Raw RGBA at 4K 60 fps is about 4 GB/s, the clip needs to be in the page cache or on fast storage
+class StereoFrameSource : public ofThread
+{
+public:
+	StereoFrameSource();
+	virtual ~StereoFrameSource();
+
+	// 'width'/'height' of each view, they must match the eye resolution of the barrier
+	bool open(const string &fileName, int width, int height, int layout, float frameRate, bool loop = true);
+	// needs the GL context, like 'update'
+	void close();
+	bool isOpen();
+
+	int getFrameCount();
+	// frame shown by the last 'update', -1 before the first one
+	int getFrame();
+	unsigned long getLateFrames();
+	unsigned long getDroppedFrames();
+
+	// uploads the newest due frame into the views of 'parallaxBarrier', false when no new frame was uploaded
+	bool update(ParallaxBarrier &parallaxBarrier);
+
+protected:
+	void threadedFunction();
+
+private:
+	enum SlotState { SLOT_FREE, SLOT_READY, SLOT_UPLOADED };
+
+	struct Slot
+	{
+		GLuint buffer;
+		unsigned char* data;
+		GLsync fence;
+		// frames since playback started, the clip frame is 'sequence % frame count'
+		unsigned long long sequence;
+		atomic<int> state;
+	};
+
+	bool initializeBuffers();
+	void copyFrame(int frame, unsigned char* destination);
+	void uploadFrame(ParallaxBarrier &parallaxBarrier, const unsigned char* pixels);
+
+	MemoryMappedFile file;
+	int width;
+	int height;
+	int layout;
+	float frameRate;
+	bool loop;
+	int frameCount;
+	size_t frameSize;
+
+	Slot slots[STEREO_FRAME_SOURCE_RING_SIZE];
+	bool persistentBuffers;
+	bool buffersInitialized;
+	// render thread ring position, the prefetcher fills slots in the same order
+	int nextSlot;
+	vector<unsigned char> fallbackPixels;
+
+	unsigned long long startTime;
+	// newest frame due, the prefetcher skips frames older than it
+	atomic<unsigned long long> dueSequence;
+	int frame;
+	unsigned long lateFrames;
+	unsigned long droppedFrames;
+};
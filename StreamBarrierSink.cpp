@@ -0,0 +1,97 @@
+#include "StreamBarrierSink.h"
+
+StreamBarrierSink::StreamBarrierSink(const string &fileName, int keyInterval): BarrierSink(keyInterval), fileName(fileName), file(NULL), stopping(false), writeFailed(false), droppedPackets(0)
+{
+	droppedPacketsMetric = &MetricsRegistry::get().counter("parallax_barrier_sink_dropped_packets_total", "Barrier packets dropped because the sink stream did not keep up");
+}
+
+StreamBarrierSink::~StreamBarrierSink()
+{
+	stop();
+}
+
+unsigned long StreamBarrierSink::getDroppedPackets()
+{
+	lock_guard<mutex> lock(queueMutex);
+	return droppedPackets;
+}
+
+bool StreamBarrierSink::open()
+{
+	file = fopen(fileName.c_str(), "wb");
+	if (file == NULL)
+	{
+		ofLogError("StreamBarrierSink") << "could not open '" << fileName << "'";
+		return false;
+	}
+
+	queue.clear();
+	stopping = false;
+	writeFailed = false;
+	writer = thread(&StreamBarrierSink::runWriter, this);
+	return true;
+}
+
+void StreamBarrierSink::close()
+{
+	//queued packets are still written
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+	if (writer.joinable())
+		writer.join();
+
+	if (file != NULL)
+		fclose(file);
+	file = NULL;
+}
+
+bool StreamBarrierSink::write(const unsigned char* data, size_t size)
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		if (writeFailed)
+			return false;
+
+		if (queue.size() >= STREAM_BARRIER_SINK_QUEUE_SIZE)
+		{
+			//deltas only apply in order, the stream restarts from the next key packet
+			droppedPackets += queue.size() + 1;
+			droppedPacketsMetric->increment(queue.size() + 1);
+			queue.clear();
+			requestKeyPacket();
+			return true;
+		}
+
+		queue.push_back(vector<unsigned char>(data, data + size));
+	}
+	queueCondition.notify_one();
+	return true;
+}
+
+void StreamBarrierSink::runWriter()
+{
+	while (true)
+	{
+		vector<unsigned char> packet;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+			packet.swap(queue.front());
+			queue.pop_front();
+		}
+
+		if (fwrite(&packet[0], packet.size(), 1, file) != 1 || fflush(file) != 0)
+		{
+			ofLogError("StreamBarrierSink") << "could not write to '" << fileName << "'";
+			lock_guard<mutex> lock(queueMutex);
+			writeFailed = true;
+			return;
+		}
+		countPacket(packet.size());
+	}
+}
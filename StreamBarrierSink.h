@@ -0,0 +1,47 @@
+#pragma once
+
+#include "BarrierSink.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// packets waiting for the writer thread, on overflow they are dropped for a key packet
+#define STREAM_BARRIER_SINK_QUEUE_SIZE 8
+
+// StreamBarrierSink writes barrier packets to a byte stream opened as a file: a serial device
+// (e.g. '/dev/ttyACM0' or 'COM3', configured beforehand), a named pipe or a plain file for inspection.
+// Packets are queued by the render thread and written (and flushed) by a writer thread, so a slow
+// link never stalls presentation. When the queue is full the queued packets are dropped and the
+// next packet is a key packet, the receiver skips the deltas in between (see BarrierRunDecoder)
+class StreamBarrierSink : public BarrierSink
+{
+public:
+	StreamBarrierSink(const string &fileName, int keyInterval = BARRIER_PACKET_KEY_INTERVAL);
+	virtual ~StreamBarrierSink();
+
+	// packets dropped because the stream did not keep up, they are not counted as sent
+	unsigned long getDroppedPackets();
+
+protected:
+	bool open();
+	void close();
+	bool write(const unsigned char* data, size_t size);
+
+private:
+	void runWriter();
+
+	string fileName;
+	FILE* file;
+
+	thread writer;
+	mutex queueMutex;
+	condition_variable queueCondition;
+	deque<vector<unsigned char> > queue;
+	bool stopping;
+	bool writeFailed;
+	unsigned long droppedPackets;
+	MetricCounter* droppedPacketsMetric;
+};
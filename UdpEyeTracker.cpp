@@ -0,0 +1,55 @@
+#include "UdpEyeTracker.h"
+
+UdpEyeTracker::UdpEyeTracker(int port): port(port)
+{
+}
+
+UdpEyeTracker::~UdpEyeTracker()
+{
+}
+
+bool UdpEyeTracker::open()
+{
+	if (!udpConnection.Create() || !udpConnection.Bind(port))
+	{
+		ofLogError("UdpEyeTracker") << "could not bind port " << port;
+		return false;
+	}
+
+	//blocking receive with a timeout, so 'stop' is not delayed by a silent tracker
+	udpConnection.SetNonBlocking(false);
+	udpConnection.SetTimeoutReceive(1);
+
+	return true;
+}
+
+void UdpEyeTracker::close()
+{
+	udpConnection.Close();
+}
+
+bool UdpEyeTracker::readSample(EyeTrackerSample &sample)
+{
+	while (isThreadRunning())
+	{
+		int size = udpConnection.Receive(buffer, UDP_EYE_TRACKER_BUFFER_SIZE - 1);
+		if (size <= 0)
+			continue;
+		buffer[size] = '\0';
+
+		float values[7];
+		int count = sscanf(buffer, "%f %f %f %f %f %f %f", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5], &values[6]);
+		if (count < 6)
+		{
+			ofLogWarning("UdpEyeTracker") << "invalid datagram '" << buffer << "'";
+			continue;
+		}
+
+		float *positions = count == 7? values + 1 : values;
+		sample.leftEyePosition.set(positions[0], positions[1], positions[2]);
+		sample.rightEyePosition.set(positions[3], positions[4], positions[5]);
+		return true;
+	}
+
+	return false;
+}
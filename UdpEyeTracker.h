@@ -0,0 +1,26 @@
+#pragma once
+
+#include "EyeTracker.h"
+#include "ofxNetwork.h"
+
+#define UDP_EYE_TRACKER_BUFFER_SIZE 1024
+
+// UdpEyeTracker receives eye positions as text datagrams: 'lx ly lz rx ry rz',
+// optionally preceded by a time column which is ignored, so recorded trajectory
+// lines can be replayed over the network as is
+class UdpEyeTracker : public EyeTracker
+{
+public:
+	UdpEyeTracker(int port);
+	virtual ~UdpEyeTracker();
+
+protected:
+	bool open();
+	void close();
+	bool readSample(EyeTrackerSample &sample);
+
+private:
+	int port;
+	ofxUDPManager udpConnection;
+	char buffer[UDP_EYE_TRACKER_BUFFER_SIZE];
+};
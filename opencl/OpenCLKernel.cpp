@@ -239,7 +239,7 @@ bool OpenCLKernel::defineArguments(const list<OpenCLBuffer*> * readWriteBuffers,
 	return true;
 }
 
-bool OpenCLKernel::execute(const int &workDimension, const size_t* globalSize, const size_t* localSize)
+bool OpenCLKernel::execute(const int &workDimension, const size_t* globalSize, const size_t* localSize, int rangeCount, const size_t* globalOffsets)
 {
 	list<OpenCLBuffer *>::const_iterator iterator, end;
 
@@ -310,9 +310,12 @@ bool OpenCLKernel::execute(const int &workDimension, const size_t* globalSize, c
 	}
 
 	/* Execute OpenCL Kernel */
-	status = clEnqueueNDRangeKernel(command_queue, kernel, workDimension, NULL, globalSize, localSize, 0, NULL, NULL);
-	if (status != CL_SUCCESS)
-		return false;
+	for (int range = 0; range < rangeCount; range++)
+	{
+		status = clEnqueueNDRangeKernel(command_queue, kernel, workDimension, globalOffsets != NULL? globalOffsets + range * workDimension : NULL, globalSize + range * workDimension, localSize, 0, NULL, NULL);
+		if (status != CL_SUCCESS)
+			return false;
+	}
 
 	// Copy results from read/write Memory Objects
 	for (iterator = readWriteBufferList.begin(), end = readWriteBufferList.end(); iterator != end; ++iterator)
@@ -29,7 +29,9 @@ public:
 
 	string getFileName();
 	bool defineArguments(const list<OpenCLBuffer*> * readWriteBuffers, const list<OpenCLBuffer*> * readBuffers, const list<OpenCLBuffer*> * writeBuffers, const list<OpenCLTexture*> * readTextures, const list<OpenCLTexture*> * writeTextures);
-	bool execute(const int &workDimension, const size_t* globalSize, const size_t* localSize);
+	// with several ranges 'globalSize' and 'globalOffsets' (NULL for no offsets) hold 'workDimension' 
+	// values per range, all ranges run between one acquire and release of the shared GL objects
+	bool execute(const int &workDimension, const size_t* globalSize, const size_t* localSize, int rangeCount = 1, const size_t* globalOffsets = NULL);
 	cl_int getStatus();
 
 
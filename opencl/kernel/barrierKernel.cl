@@ -24,4 +24,26 @@ __kernel void updateBarrierPixels(	const __global char* barrierPoints,
 		write_imagef(barrierImage, coord, color);
 	}
 
-}
\ No newline at end of file
+}
+
+// subpixel maps hold one transparency per channel (red, green, blue) of each barrier pixel
+__kernel void updateBarrierPixelsSubpixel(	const __global char* barrierPoints,
+											__write_only image2d_t barrierImage)
+{
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+
+	const int barrierImageWidth = get_image_width(barrierImage);
+	const int barrierImageHeight = get_image_height(barrierImage);
+
+	if (i < barrierImageWidth && j < barrierImageHeight)
+	{
+		int2 coord = (int2) (i, j);
+		char3 points = vload3(i, barrierPoints);
+		
+		float4 color = (float4) (points.x == 1? 1.f : 0.f, points.y == 1? 1.f : 0.f, points.z == 1? 1.f : 0.f, 1.f);
+
+		write_imagef(barrierImage, coord, color);
+	}
+
+}
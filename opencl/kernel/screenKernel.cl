@@ -1,3 +1,7 @@
+// left/right images narrower than the screen image are resampled with linear filtering,
+// images with the screen image width are read texel by texel
+__constant sampler_t eyeSampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
 __kernel void updateScreenPixels(	const __global char* screenPoints, 
 									__read_only image2d_t leftImage, __read_only image2d_t rightImage, 
 									__write_only image2d_t screenImage)
@@ -7,19 +11,21 @@ __kernel void updateScreenPixels(	const __global char* screenPoints,
 
 	const int screenImageWidth = get_image_width(screenImage);
 	const int screenImageHeight = get_image_height(screenImage);
+	const int eyeImageWidth = get_image_width(leftImage);
 
 	if (i < screenImageWidth && j < screenImageHeight)
 	{
 		int2 coord = (int2) (i, j);
+		float2 eyeCoord = (float2) ((i + 0.5f) * eyeImageWidth / screenImageWidth, j + 0.5f);
 		
 		float4 color;
 		if (screenPoints[i] == -1)
 		{
-			color = read_imagef(leftImage, coord);
+			color = eyeImageWidth == screenImageWidth? read_imagef(leftImage, coord) : read_imagef(leftImage, eyeSampler, eyeCoord);
 		} 
 		else if (screenPoints[i] == 1)
 		{
-			color = read_imagef(rightImage, coord);
+			color = eyeImageWidth == screenImageWidth? read_imagef(rightImage, coord) : read_imagef(rightImage, eyeSampler, eyeCoord);
 		}
 		else 
 		{
@@ -29,4 +35,97 @@ __kernel void updateScreenPixels(	const __global char* screenPoints,
 		write_imagef(screenImage, coord, color);
 	}
 
-}
\ No newline at end of file
+}
+
+__kernel void updateScreenPixelsLayered(	const __global char* screenPoints, 
+											__read_only image2d_array_t stereoImage, 
+											__write_only image2d_t screenImage)
+{
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+
+	const int screenImageWidth = get_image_width(screenImage);
+	const int screenImageHeight = get_image_height(screenImage);
+	const int eyeImageWidth = get_image_width(stereoImage);
+
+	if (i < screenImageWidth && j < screenImageHeight)
+	{
+		int2 coord = (int2) (i, j);
+		float eyeCoordX = (i + 0.5f) * eyeImageWidth / screenImageWidth;
+		
+		// layer 0 holds the left view, layer 1 holds the right view
+		float4 color;
+		if (screenPoints[i] == -1)
+		{
+			color = eyeImageWidth == screenImageWidth? read_imagef(stereoImage, (int4) (i, j, 0, 0)) : read_imagef(stereoImage, eyeSampler, (float4) (eyeCoordX, j + 0.5f, 0.f, 0.f));
+		} 
+		else if (screenPoints[i] == 1)
+		{
+			color = eyeImageWidth == screenImageWidth? read_imagef(stereoImage, (int4) (i, j, 1, 0)) : read_imagef(stereoImage, eyeSampler, (float4) (eyeCoordX, j + 0.5f, 1.f, 0.f));
+		}
+		else 
+		{
+			color = (float4) (0,0,0,1);
+		}
+
+		write_imagef(screenImage, coord, color);
+	}
+
+}
+// subpixel maps hold one view per channel (red, green, blue) of each screen pixel
+inline float selectChannel(char point, float left, float right)
+{
+	return point == -1? left : (point == 1? right : 0.f);
+}
+
+__kernel void updateScreenPixelsSubpixel(	const __global char* screenPoints, 
+											__read_only image2d_t leftImage, __read_only image2d_t rightImage, 
+											__write_only image2d_t screenImage)
+{
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+
+	const int screenImageWidth = get_image_width(screenImage);
+	const int screenImageHeight = get_image_height(screenImage);
+	const int eyeImageWidth = get_image_width(leftImage);
+
+	if (i < screenImageWidth && j < screenImageHeight)
+	{
+		int2 coord = (int2) (i, j);
+		float2 eyeCoord = (float2) ((i + 0.5f) * eyeImageWidth / screenImageWidth, j + 0.5f);
+		char3 points = vload3(i, screenPoints);
+
+		float4 left = eyeImageWidth == screenImageWidth? read_imagef(leftImage, coord) : read_imagef(leftImage, eyeSampler, eyeCoord);
+		float4 right = eyeImageWidth == screenImageWidth? read_imagef(rightImage, coord) : read_imagef(rightImage, eyeSampler, eyeCoord);
+		float4 color = (float4) (selectChannel(points.x, left.x, right.x), selectChannel(points.y, left.y, right.y), selectChannel(points.z, left.z, right.z), 1.f);
+
+		write_imagef(screenImage, coord, color);
+	}
+
+}
+
+__kernel void updateScreenPixelsLayeredSubpixel(	const __global char* screenPoints, 
+													__read_only image2d_array_t stereoImage, 
+													__write_only image2d_t screenImage)
+{
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+
+	const int screenImageWidth = get_image_width(screenImage);
+	const int screenImageHeight = get_image_height(screenImage);
+	const int eyeImageWidth = get_image_width(stereoImage);
+
+	if (i < screenImageWidth && j < screenImageHeight)
+	{
+		int2 coord = (int2) (i, j);
+		float eyeCoordX = (i + 0.5f) * eyeImageWidth / screenImageWidth;
+		char3 points = vload3(i, screenPoints);
+
+		float4 left = eyeImageWidth == screenImageWidth? read_imagef(stereoImage, (int4) (i, j, 0, 0)) : read_imagef(stereoImage, eyeSampler, (float4) (eyeCoordX, j + 0.5f, 0.f, 0.f));
+		float4 right = eyeImageWidth == screenImageWidth? read_imagef(stereoImage, (int4) (i, j, 1, 0)) : read_imagef(stereoImage, eyeSampler, (float4) (eyeCoordX, j + 0.5f, 1.f, 0.f));
+		float4 color = (float4) (selectChannel(points.x, left.x, right.x), selectChannel(points.y, left.y, right.y), selectChannel(points.z, left.z, right.z), 1.f);
+
+		write_imagef(screenImage, coord, color);
+	}
+
+}
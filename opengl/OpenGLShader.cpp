@@ -0,0 +1,164 @@
+#include "OpenGLShader.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "ofLog.h"
+
+OpenGLShader::OpenGLShader(const string &vertexFileName, const string &fragmentFileName, const string &geometryFileName, const string &header): vertexFileName(vertexFileName), fragmentFileName(fragmentFileName), geometryFileName(geometryFileName), header(header), program(0), status(false)
+{
+	initialize();
+}
+
+static string getShaderContents(const string &filename)
+{
+	std::ifstream in(filename, std::ios::in | std::ios::binary);
+	if (in)
+	{
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		in.close();
+		return(contents.str());
+	}
+	ofLogError("OpenGLShader") << "could not read " << filename;
+	return "";
+}
+
+void OpenGLShader::initialize()
+{
+	GLuint vertexShader, fragmentShader, geometryShader = 0;
+	GLint linked;
+
+	program = glCreateProgram();
+
+	vertexShader = compile(GL_VERTEX_SHADER, vertexFileName);
+	fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentFileName);
+	if (!geometryFileName.empty())
+		geometryShader = compile(GL_GEOMETRY_SHADER, geometryFileName);
+
+	if (vertexShader == 0 || fragmentShader == 0 || (!geometryFileName.empty() && geometryShader == 0))
+	{
+		//delete the stages that did compile, status stays false
+		if (vertexShader != 0)
+			glDeleteShader(vertexShader);
+		if (fragmentShader != 0)
+			glDeleteShader(fragmentShader);
+		if (geometryShader != 0)
+			glDeleteShader(geometryShader);
+		destroy();
+		return;
+	}
+
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	if (geometryShader != 0)
+		glAttachShader(program, geometryShader);
+
+	glLinkProgram(program);
+
+	//shader objects are kept alive by the program
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	if (geometryShader != 0)
+		glDeleteShader(geometryShader);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		GLchar log[1024];
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		ofLogError("OpenGLShader") << "link failed: " << log;
+		destroy();
+		return;
+	}
+
+	status = true;
+}
+
+GLuint OpenGLShader::compile(GLenum type, const string &fileName)
+{
+	string sourceString = getShaderContents(fileName);
+	if (sourceString.empty())
+		return 0;
+	if (!header.empty())
+	{
+		//'#version' must stay the first line
+		size_t versionEnd = sourceString.compare(0, 8, "#version") == 0? sourceString.find('\n') : string::npos;
+		sourceString.insert(versionEnd != string::npos? versionEnd + 1 : 0, header + "\n");
+	}
+	const GLchar *sourceCString = sourceString.c_str();
+	GLint compiled;
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &sourceCString, NULL);
+	glCompileShader(shader);
+
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (compiled != GL_TRUE)
+	{
+		GLchar log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		ofLogError("OpenGLShader") << fileName << ": " << log;
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+void OpenGLShader::begin()
+{
+	glUseProgram(program);
+}
+
+void OpenGLShader::end()
+{
+	glUseProgram(0);
+}
+
+GLint OpenGLShader::getUniformLocation(const string &name)
+{
+	return glGetUniformLocation(program, name.c_str());
+}
+
+void OpenGLShader::setUniform1i(const string &name, GLint value)
+{
+	glUniform1i(getUniformLocation(name), value);
+}
+
+void OpenGLShader::setUniform1f(const string &name, GLfloat value)
+{
+	glUniform1f(getUniformLocation(name), value);
+}
+
+void OpenGLShader::setUniform2f(const string &name, GLfloat x, GLfloat y)
+{
+	glUniform2f(getUniformLocation(name), x, y);
+}
+
+void OpenGLShader::setUniformMatrix4fv(const string &name, const GLfloat *matrices, GLsizei count)
+{
+	glUniformMatrix4fv(getUniformLocation(name), count, GL_FALSE, matrices);
+}
+
+GLuint OpenGLShader::getProgram()
+{
+	return program;
+}
+
+bool OpenGLShader::getStatus()
+{
+	return status;
+}
+
+OpenGLShader::~OpenGLShader()
+{
+	destroy();
+}
+
+void OpenGLShader::destroy()
+{
+	//deleting program 0 is silently ignored
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+#ifdef __APPLE__ 
+	#import <OpenGL/glew.h>
+#else
+	#include <GL/glew.h>
+#endif
+
+using namespace std;
+
+class OpenGLShader
+{
+public:
+	// 'header' (e.g. '#define' lines) is inserted after the '#version' line of every stage
+	OpenGLShader(const string &vertexFileName, const string &fragmentFileName, const string &geometryFileName = "", const string &header = "");
+	virtual ~OpenGLShader(void);
+
+	void begin();
+	void end();
+
+	GLint getUniformLocation(const string &name);
+	void setUniform1i(const string &name, GLint value);
+	void setUniform1f(const string &name, GLfloat value);
+	void setUniform2f(const string &name, GLfloat x, GLfloat y);
+	void setUniformMatrix4fv(const string &name, const GLfloat *matrices, GLsizei count = 1);
+
+	GLuint getProgram();
+	// false when a file could not be read or a stage failed to compile/link (the program is then 0)
+	bool getStatus();
+
+private:
+	const string vertexFileName;
+	const string fragmentFileName;
+	const string geometryFileName;
+	const string header;
+	GLuint program;
+	bool status;
+
+	void initialize();
+	GLuint compile(GLenum type, const string &fileName);
+	void destroy();
+};
@@ -0,0 +1,44 @@
+#version 150 compatibility
+
+// same output as the barrierKernel.cl kernel
+// - PACKED_BARRIER: one bit per column, column i is bit i % 8 of texel i / 8
+// - SUBPIXEL: three columns per pixel, one per channel (red, green, blue)
+
+#ifdef PACKED_BARRIER
+uniform usampler2D barrierPoints;
+#else
+uniform isampler2D barrierPoints;
+#endif
+
+in vec2 screenCoord;
+
+int readBarrierPoint(int column)
+{
+#ifdef PACKED_BARRIER
+	uint packedPoints = texelFetch(barrierPoints, ivec2(column / 8, 0), 0).r;
+	return int((packedPoints >> uint(column % 8)) & 1u);
+#else
+	return texelFetch(barrierPoints, ivec2(column, 0), 0).r;
+#endif
+}
+
+void main()
+{
+	int column = int(floor(screenCoord.x));
+#ifdef SUBPIXEL
+	gl_FragColor = vec4(0, 0, 0, 1);
+	for (int channel = 0; channel < 3; channel++)
+	{
+		gl_FragColor[channel] = readBarrierPoint(column * 3 + channel) == 1? 1.0 : 0.0;
+	}
+#else
+	if (readBarrierPoint(column) == 1)
+	{
+		gl_FragColor = vec4(1, 1, 1, 1);
+	}
+	else
+	{
+		gl_FragColor = vec4(0, 0, 0, 1);
+	}
+#endif
+}
@@ -0,0 +1,11 @@
+#version 150 compatibility
+
+out vec2 screenCoord;
+
+void main()
+{
+	//texture coordinates hold the target pixel coordinates (0..width, 0..height)
+	gl_Position = ftransform();
+	gl_FrontColor = gl_Color;
+	screenCoord = gl_MultiTexCoord0.xy;
+}
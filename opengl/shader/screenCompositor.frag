@@ -0,0 +1,72 @@
+#version 150 compatibility
+
+// same output as the screenKernel.cl kernels:
+// - LAYERED_STEREO: views are layer 0 (left) and 1 (right) of a 2D texture array
+// - EYE_TEXTURE_RECTANGLE: views are rectangle textures, otherwise 2D textures
+// - SUBPIXEL: three screen points per column, one view per channel (red, green, blue)
+// views with the screen width are read texel by texel, narrower views are 
+// resampled with linear filtering at the column center
+
+uniform isampler2D screenPoints;
+uniform vec2 screenSize;
+uniform float eyeWidth;
+
+#ifdef LAYERED_STEREO
+uniform sampler2DArray stereoImage;
+#elif defined(EYE_TEXTURE_RECTANGLE)
+uniform sampler2DRect leftImage;
+uniform sampler2DRect rightImage;
+#else
+uniform sampler2D leftImage;
+uniform sampler2D rightImage;
+#endif
+
+in vec2 screenCoord;
+
+vec4 readView(int view, ivec2 coord, vec2 eyeCoord)
+{
+#ifdef LAYERED_STEREO
+	if (eyeWidth == screenSize.x)
+		return texelFetch(stereoImage, ivec3(coord, view), 0);
+	return texture(stereoImage, vec3(eyeCoord / vec2(eyeWidth, screenSize.y), view));
+#elif defined(EYE_TEXTURE_RECTANGLE)
+	if (eyeWidth == screenSize.x)
+		return view == 0? texelFetch(leftImage, coord) : texelFetch(rightImage, coord);
+	return view == 0? texture(leftImage, eyeCoord) : texture(rightImage, eyeCoord);
+#else
+	if (eyeWidth == screenSize.x)
+		return view == 0? texelFetch(leftImage, coord, 0) : texelFetch(rightImage, coord, 0);
+	return view == 0? texture(leftImage, eyeCoord / vec2(eyeWidth, screenSize.y)) : texture(rightImage, eyeCoord / vec2(eyeWidth, screenSize.y));
+#endif
+}
+
+void main()
+{
+	ivec2 coord = ivec2(floor(screenCoord));
+	vec2 eyeCoord = vec2((coord.x + 0.5) * eyeWidth / screenSize.x, coord.y + 0.5);
+
+#ifdef SUBPIXEL
+	vec4 left = readView(0, coord, eyeCoord);
+	vec4 right = readView(1, coord, eyeCoord);
+	gl_FragColor = vec4(0, 0, 0, 1);
+	for (int channel = 0; channel < 3; channel++)
+	{
+		int screenPoint = texelFetch(screenPoints, ivec2(coord.x * 3 + channel, 0), 0).r;
+		gl_FragColor[channel] = screenPoint == -1? left[channel] : (screenPoint == 1? right[channel] : 0.0);
+	}
+#else
+	int screenPoint = texelFetch(screenPoints, ivec2(coord.x, 0), 0).r;
+	if (screenPoint == -1)
+	{
+		gl_FragColor = readView(0, coord, eyeCoord);
+	}
+	else if (screenPoint == 1)
+	{
+		gl_FragColor = readView(1, coord, eyeCoord);
+	}
+	else
+	{
+		gl_FragColor = vec4(0, 0, 0, 1);
+	}
+#endif
+}
@@ -0,0 +1,19 @@
+#version 150 compatibility
+
+uniform int useTexture;
+uniform sampler2DRect tex0;
+
+in vec4 fragmentColor;
+in vec2 fragmentTexCoord;
+
+void main()
+{
+	if (useTexture == 1)
+	{
+		gl_FragColor = fragmentColor * texture(tex0, fragmentTexCoord);
+	}
+	else
+	{
+		gl_FragColor = fragmentColor;
+	}
+}
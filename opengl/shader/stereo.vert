@@ -0,0 +1,13 @@
+#version 150 compatibility
+
+out vec4 vertexColor;
+out vec2 vertexTexCoord;
+
+void main()
+{
+	//eye view and projection are applied per layer in the geometry shader,
+	//so the modelview matrix only has to hold the scene (model) transformation
+	gl_Position = gl_ModelViewMatrix * gl_Vertex;
+	vertexColor = gl_Color;
+	vertexTexCoord = gl_MultiTexCoord0.xy;
+}
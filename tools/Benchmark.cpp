@@ -0,0 +1,221 @@
+// Microbenchmark of the CPU side of the pipeline
+// Sweeps resolutions, barrier widths, spacings and eye positions and measures
+// - ParallaxBarrierModel::update
+// - boundary to column rasterization (ParallaxBarrierRasterizer::rasterize)
+// - compositing (ParallaxBarrierCompositor, the CPU version of the kernels)
+// reporting ns/frame, heap allocations per frame and boundary counts as JSON.
+//
+// usage: Benchmark [--output file.json] [--quick]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ParallaxBarrierRasterizer.h"
+#include "ParallaxBarrierCompositor.h"
+
+using namespace std;
+
+// every heap allocation in the process is counted
+static atomic<unsigned long long> allocationCount(0);
+
+void* operator new(size_t size)
+{
+	allocationCount++;
+	void *pointer = malloc(size > 0? size : 1);
+	if (pointer == NULL)
+		throw bad_alloc();
+	return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+	free(pointer);
+}
+
+struct Resolution
+{
+	const char *name;
+	int width, height;
+};
+
+struct Measure
+{
+	double nanoseconds;
+	double allocations;
+};
+
+// runs 'frame' until both the minimum iterations and minimum time are reached
+template <class Frame>
+static Measure measure(Frame frame, int minIterations, double minSeconds)
+{
+	typedef chrono::steady_clock clock;
+	Measure result;
+	int iterations = 0;
+	unsigned long long allocations = allocationCount;
+	clock::time_point start = clock::now();
+	double elapsed = 0;
+
+	while (iterations < minIterations || elapsed < minSeconds)
+	{
+		frame(iterations);
+		iterations++;
+		elapsed = chrono::duration<double>(clock::now() - start).count();
+	}
+
+	result.nanoseconds = elapsed * 1e9 / iterations;
+	result.allocations = (double) (allocationCount - allocations) / iterations;
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *outputFileName = NULL;
+	bool quick = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--output" && i + 1 < argc)
+			outputFileName = argv[++i];
+		else if (string(argv[i]) == "--quick")
+			quick = true;
+		else
+		{
+			fprintf(stderr, "usage: Benchmark [--output file.json] [--quick]\n");
+			return 1;
+		}
+	}
+
+	FILE *out = outputFileName != NULL? fopen(outputFileName, "w") : stdout;
+	if (out == NULL)
+	{
+		fprintf(stderr, "could not open '%s'\n", outputFileName);
+		return 1;
+	}
+
+	const Resolution resolutions[] = { {"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4K", 3840, 2160}, {"8K", 7680, 4320} };
+	// physical units are centimeters
+	const float widths[] = { 52.f, 70.f, 120.f };
+	const float spacings[] = { 0.3f, 0.5f, 0.8f };
+	const float eyeSeparation = 6.4f;
+	const int eyePositionCount = 64;
+	const int minIterations = quick? 10 : 200;
+	const double minSeconds = quick? 0.01 : 0.2;
+
+	// eye positions sweep a band in front of the screen, centered on it
+	vector<ofVec3f> eyeCenters;
+	for (int i = 0; i < eyePositionCount; i++)
+	{
+		float t = (float) i / (eyePositionCount - 1);
+		eyeCenters.push_back(ofVec3f((t - 0.5f) * 40.f, 0.f, 45.f + 60.f * fmod(t * 7.f, 1.f)));
+	}
+
+	fprintf(out, "{\n\t\"eyePositions\": %d,\n\t\"geometry\": [", eyePositionCount);
+
+	bool first = true;
+	for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++)
+	{
+		for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+		{
+			for (size_t s = 0; s < sizeof(spacings) / sizeof(spacings[0]); s++)
+			{
+				const Resolution &resolution = resolutions[r];
+				ParallaxBarrierRasterizer rasterizer(widths[w], resolution.width, resolution.width, spacings[s], ofVec3f(0, 0, 0), ofVec3f(0, 0, 1), ofVec3f(0, 1, 0));
+				ParallaxBarrierModel &model = rasterizer.getModel();
+
+				// model coordinates of each eye pair
+				vector<ofVec2f> modelLeftEyes, modelRightEyes;
+				for (int i = 0; i < eyePositionCount; i++)
+				{
+					ofVec3f left = (eyeCenters[i] - ofVec3f(eyeSeparation * 0.5f, 0, 0)) * rasterizer.getModelTransformation();
+					ofVec3f right = (eyeCenters[i] + ofVec3f(eyeSeparation * 0.5f, 0, 0)) * rasterizer.getModelTransformation();
+					modelLeftEyes.push_back(ofVec2f(left.x, left.z));
+					modelRightEyes.push_back(ofVec2f(right.x, right.z));
+				}
+
+				int modelFailures = 0;
+				size_t screenBoundaries = 0, barrierBoundaries = 0;
+				for (int i = 0; i < eyePositionCount; i++)
+				{
+					if (!rasterizer.update(eyeCenters[i] - ofVec3f(eyeSeparation * 0.5f, 0, 0), eyeCenters[i] + ofVec3f(eyeSeparation * 0.5f, 0, 0)))
+						modelFailures++;
+					screenBoundaries += model.getScreenPoints().size();
+					barrierBoundaries += model.getBarrierPoints().size();
+				}
+
+				Measure modelMeasure = measure([&](int i) {
+					model.update(modelLeftEyes[i % eyePositionCount], modelRightEyes[i % eyePositionCount]);
+				}, minIterations, minSeconds);
+
+				// rasterization uses the model points of the last eye position
+				Measure rasterizationMeasure = measure([&](int i) {
+					rasterizer.rasterize((i & 1) != 0);
+				}, minIterations, minSeconds);
+
+				rasterizer.setFixedPoint(true);
+				Measure fixedPointMeasure = measure([&](int i) {
+					rasterizer.rasterize((i & 1) != 0);
+				}, minIterations, minSeconds);
+				rasterizer.setFixedPoint(false);
+
+				Measure updateMeasure = measure([&](int i) {
+					rasterizer.update(eyeCenters[i % eyePositionCount] - ofVec3f(eyeSeparation * 0.5f, 0, 0), eyeCenters[i % eyePositionCount] + ofVec3f(eyeSeparation * 0.5f, 0, 0));
+				}, minIterations, minSeconds);
+
+				fprintf(out, "%s\n\t\t{\"resolution\": \"%s\", \"screenWidth\": %d, \"width\": %g, \"spacing\": %g, "
+					"\"modelNs\": %.1f, \"modelAllocations\": %.2f, "
+					"\"rasterizationNs\": %.1f, \"rasterizationAllocations\": %.2f, \"fixedPointRasterizationNs\": %.1f, "
+					"\"updateNs\": %.1f, \"updateAllocations\": %.2f, "
+					"\"screenBoundaries\": %.1f, \"barrierBoundaries\": %.1f, \"modelFailures\": %d}",
+					first? "" : ",", resolution.name, resolution.width, widths[w], spacings[s],
+					modelMeasure.nanoseconds, modelMeasure.allocations,
+					rasterizationMeasure.nanoseconds, rasterizationMeasure.allocations, fixedPointMeasure.nanoseconds,
+					updateMeasure.nanoseconds, updateMeasure.allocations,
+					(double) screenBoundaries / eyePositionCount, (double) barrierBoundaries / eyePositionCount, modelFailures);
+				first = false;
+			}
+		}
+	}
+
+	fprintf(out, "\n\t],\n\t\"compositor\": [");
+
+	// compositing cost only depends on the resolution
+	first = true;
+	for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++)
+	{
+		const Resolution &resolution = resolutions[r];
+		ParallaxBarrierRasterizer rasterizer(widths[0], resolution.width, resolution.width, spacings[1], ofVec3f(0, 0, 0), ofVec3f(0, 0, 1), ofVec3f(0, 1, 0));
+		rasterizer.update(ofVec3f(-eyeSeparation * 0.5f, 0, 60), ofVec3f(eyeSeparation * 0.5f, 0, 60));
+
+		ofPixels leftPixels, rightPixels, screenPixels, barrierPixels;
+		leftPixels.allocate(resolution.width, resolution.height, OF_IMAGE_COLOR_ALPHA);
+		rightPixels.allocate(resolution.width, resolution.height, OF_IMAGE_COLOR_ALPHA);
+		screenPixels.allocate(resolution.width, resolution.height, OF_IMAGE_COLOR_ALPHA);
+		barrierPixels.allocate(resolution.width, resolution.height, OF_IMAGE_COLOR_ALPHA);
+
+		Measure screenMeasure = measure([&](int) {
+			ParallaxBarrierCompositor::compositeScreen(rasterizer.getScreenPoints(), leftPixels, rightPixels, screenPixels);
+		}, quick? 2 : 10, minSeconds);
+
+		Measure barrierMeasure = measure([&](int) {
+			ParallaxBarrierCompositor::compositeBarrier(rasterizer.getBarrierPoints(), barrierPixels);
+		}, quick? 2 : 10, minSeconds);
+
+		fprintf(out, "%s\n\t\t{\"resolution\": \"%s\", \"screenWidth\": %d, \"screenHeight\": %d, "
+			"\"screenNs\": %.1f, \"screenAllocations\": %.2f, \"barrierNs\": %.1f, \"barrierAllocations\": %.2f}",
+			first? "" : ",", resolution.name, resolution.width, resolution.height,
+			screenMeasure.nanoseconds, screenMeasure.allocations, barrierMeasure.nanoseconds, barrierMeasure.allocations);
+		first = false;
+	}
+
+	fprintf(out, "\n\t]\n}\n");
+
+	if (out != stdout)
+		fclose(out);
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+// Automatic calibration
+// Searches spacing, screen offset and screen pose that best explain measured observations
+// (see ParallaxBarrierCalibration) and prints the best-fit geometry.
+//
+// usage: Calibrate --observations file --width w --spacing s --screen W --barrier W [options]
+//   --position x,y,z            initial screen center (default 0,0,0)
+//   --view x,y,z                initial screen view direction (default 0,0,1)
+//   --up x,y,z                  screen up direction (default 0,1,0)
+//   --offset x                  initial screen offset in pixels (default 0)
+//   --spacing-range r           searched spacing interval half width (default 1% of spacing)
+//   --offset-range r            searched screen offset half width in pixels (default 16)
+//   --position-range x,z        searched position half widths (default 0.5,0.5)
+//   --yaw-range degrees         searched view direction rotation half width (default 2)
+//   --steps s,p,a               spacing, position and angle steps per round
+//   --rounds n                  refinement rounds
+//   --threads n                 worker threads (default: hardware concurrency)
+//
+// observation files hold one observation per line: 'lx ly lz rx ry rz mapFile', '#' starts a comment,
+// 'mapFile' holds one signed byte per screen column (-1 left, 1 right, 0 unknown), the layout written
+// by 'OfflineRenderer --maps'
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "ParallaxBarrierCalibration.h"
+
+using namespace std;
+
+static bool parseVector(const string &value, ofVec3f &vector)
+{
+	return sscanf(value.c_str(), "%f,%f,%f", &vector.x, &vector.y, &vector.z) == 3;
+}
+
+static bool loadObservations(const string &fileName, int screenResolutionWidth, ParallaxBarrierCalibration &calibration)
+{
+	ifstream in(fileName.c_str());
+	if (!in)
+		return false;
+
+	string line;
+	while (getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		CalibrationObservation observation;
+		string mapFileName;
+		istringstream values(line);
+		values >> observation.leftEyePosition.x >> observation.leftEyePosition.y >> observation.leftEyePosition.z
+			>> observation.rightEyePosition.x >> observation.rightEyePosition.y >> observation.rightEyePosition.z
+			>> mapFileName;
+		if (values.fail())
+			return false;
+
+		ifstream map(mapFileName.c_str(), ios::in | ios::binary);
+		observation.screenPoints.resize(screenResolutionWidth);
+		if (!map.read((char*) &observation.screenPoints[0], screenResolutionWidth))
+		{
+			fprintf(stderr, "could not read %d columns from '%s'\n", screenResolutionWidth, mapFileName.c_str());
+			return false;
+		}
+
+		calibration.addObservation(observation);
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	string observationsFileName;
+	float width = 0;
+	int screenResolutionWidth = 0, barrierResolutionWidth = 0;
+	CalibrationGeometry geometry;
+	geometry.spacing = 0;
+	geometry.screenOffsetX = 0;
+	geometry.position = ofVec3f(0, 0, 0);
+	geometry.viewDirection = ofVec3f(0, 0, 1);
+	geometry.upDirection = ofVec3f(0, 1, 0);
+	CalibrationRange range;
+	range.spacing = 0;
+	range.screenOffsetX = 16;
+	range.positionX = 0.5f;
+	range.positionZ = 0.5f;
+	range.yaw = 2.f;
+	int spacingSteps = CALIBRATION_DEFAULT_SPACING_STEPS, positionSteps = CALIBRATION_DEFAULT_POSITION_STEPS, angleSteps = CALIBRATION_DEFAULT_ANGLE_STEPS;
+	int rounds = CALIBRATION_DEFAULT_ROUNDS;
+	int threads = 0;
+
+	bool valid = true;
+	for (int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		string value = i + 1 < argc? argv[i + 1] : "";
+
+		if (option == "--observations" && ++i < argc)
+			observationsFileName = value;
+		else if (option == "--width" && ++i < argc)
+			width = (float) atof(value.c_str());
+		else if (option == "--spacing" && ++i < argc)
+			geometry.spacing = (float) atof(value.c_str());
+		else if (option == "--screen" && ++i < argc)
+			screenResolutionWidth = atoi(value.c_str());
+		else if (option == "--barrier" && ++i < argc)
+			barrierResolutionWidth = atoi(value.c_str());
+		else if (option == "--offset" && ++i < argc)
+			geometry.screenOffsetX = atoi(value.c_str());
+		else if (option == "--position" && ++i < argc)
+			valid = valid && parseVector(value, geometry.position);
+		else if (option == "--view" && ++i < argc)
+			valid = valid && parseVector(value, geometry.viewDirection);
+		else if (option == "--up" && ++i < argc)
+			valid = valid && parseVector(value, geometry.upDirection);
+		else if (option == "--spacing-range" && ++i < argc)
+			range.spacing = (float) atof(value.c_str());
+		else if (option == "--offset-range" && ++i < argc)
+			range.screenOffsetX = max(0, atoi(value.c_str()));
+		else if (option == "--position-range" && ++i < argc)
+			valid = valid && sscanf(value.c_str(), "%f,%f", &range.positionX, &range.positionZ) == 2;
+		else if (option == "--yaw-range" && ++i < argc)
+			range.yaw = (float) atof(value.c_str());
+		else if (option == "--steps" && ++i < argc)
+			valid = valid && sscanf(value.c_str(), "%d,%d,%d", &spacingSteps, &positionSteps, &angleSteps) == 3;
+		else if (option == "--rounds" && ++i < argc)
+			rounds = atoi(value.c_str());
+		else if (option == "--threads" && ++i < argc)
+			threads = atoi(value.c_str());
+		else
+			valid = false;
+	}
+
+	valid = valid && width > 0 && geometry.spacing > 0 && screenResolutionWidth > 0 && barrierResolutionWidth > 0 && !observationsFileName.empty();
+	if (!valid)
+	{
+		fprintf(stderr, "usage: Calibrate --observations file --width w --spacing s --screen W --barrier W "
+			"[--position x,y,z] [--view x,y,z] [--up x,y,z] [--offset x] [--spacing-range r] [--offset-range r] "
+			"[--position-range x,z] [--yaw-range degrees] [--steps s,p,a] [--rounds n] [--threads n]\n");
+		return 1;
+	}
+
+	if (range.spacing <= 0)
+		range.spacing = geometry.spacing * 0.01f;
+
+	ParallaxBarrierCalibration calibration(width, screenResolutionWidth, barrierResolutionWidth, geometry);
+	calibration.setSteps(spacingSteps, positionSteps, angleSteps);
+	calibration.setRounds(rounds);
+	if (threads > 0)
+		calibration.setThreads(threads);
+
+	if (!loadObservations(observationsFileName, screenResolutionWidth, calibration) || calibration.getObservationCount() == 0)
+	{
+		fprintf(stderr, "could not read observations '%s'\n", observationsFileName.c_str());
+		return 1;
+	}
+
+	geometry = calibration.calibrate(range);
+
+	double seconds = calibration.getCalibrationTime() * 0.000001;
+	printf("%llu evaluations in %.3f s (%.0f evaluations/s), error %.4f\n", calibration.getEvaluationCount(), seconds, calibration.getEvaluationCount() / max(seconds, 0.000001), calibration.getError());
+	printf("spacing %f\n", geometry.spacing);
+	printf("screenOffsetX %d\n", geometry.screenOffsetX);
+	printf("position %f,%f,%f\n", geometry.position.x, geometry.position.y, geometry.position.z);
+	printf("viewDirection %f,%f,%f\n", geometry.viewDirection.x, geometry.viewDirection.y, geometry.viewDirection.z);
+	printf("upDirection %f,%f,%f\n", geometry.upDirection.x, geometry.upDirection.y, geometry.upDirection.z);
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+// Optical crosstalk sweep
+// Rasterizes and simulates (see ParallaxBarrierCrosstalk) a grid of eye positions in front of
+// the screen and reports leakage and dark band statistics per eye.
+//
+// usage: CrosstalkSweep --width w --spacing s --screen W --barrier W [options]
+//   --eye-separation d          distance between the eyes (default 6.4)
+//   --x min,max,steps           eye center x positions (default -20,20,1000)
+//   --z min,max,steps           eye center distances to the screen (default 40,100,1000)
+//   --tracking-error dx         eye x offset from the tracked position the maps are computed for (default 0)
+//   --threads n                 worker threads (default: hardware concurrency)
+//
+// the screen is centered at the origin looking along z, positions without model solution
+// are counted apart and left out of the statistics
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ParallaxBarrierCrosstalk.h"
+
+using namespace std;
+
+struct SweepRange
+{
+	float min, max;
+	int steps;
+};
+
+static bool parseRange(const string &value, SweepRange &range)
+{
+	return sscanf(value.c_str(), "%f,%f,%d", &range.min, &range.max, &range.steps) == 3 && range.steps > 0;
+}
+
+static float getRangeValue(const SweepRange &range, int step)
+{
+	return range.steps > 1? range.min + (range.max - range.min) * step / (range.steps - 1) : range.min;
+}
+
+struct EyeStatistics
+{
+	double visible, leakage, darkBand;
+	float maxLeakage;
+
+	EyeStatistics(): visible(0), leakage(0), darkBand(0), maxLeakage(0) {}
+
+	void add(const CrosstalkEyeResult &result)
+	{
+		visible += result.visible;
+		leakage += result.leakage;
+		darkBand += result.darkBand;
+		maxLeakage = max(maxLeakage, result.leakage);
+	}
+
+	void print(const char *name, int count)
+	{
+		printf("%s: visible %.4f, leakage %.4f (max %.4f), dark band %.4f\n", name, visible / count, leakage / count, maxLeakage, darkBand / count);
+	}
+};
+
+int main(int argc, char *argv[])
+{
+	float width = 0, spacing = 0, eyeSeparation = 6.4f, trackingError = 0;
+	int screenResolutionWidth = 0, barrierResolutionWidth = 0, threads = 0;
+	SweepRange xRange = { -20.f, 20.f, 1000 }, zRange = { 40.f, 100.f, 1000 };
+
+	bool valid = true;
+	for (int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		string value = i + 1 < argc? argv[i + 1] : "";
+
+		if (option == "--width" && ++i < argc)
+			width = (float) atof(value.c_str());
+		else if (option == "--spacing" && ++i < argc)
+			spacing = (float) atof(value.c_str());
+		else if (option == "--screen" && ++i < argc)
+			screenResolutionWidth = atoi(value.c_str());
+		else if (option == "--barrier" && ++i < argc)
+			barrierResolutionWidth = atoi(value.c_str());
+		else if (option == "--eye-separation" && ++i < argc)
+			eyeSeparation = (float) atof(value.c_str());
+		else if (option == "--tracking-error" && ++i < argc)
+			trackingError = (float) atof(value.c_str());
+		else if (option == "--threads" && ++i < argc)
+			threads = atoi(value.c_str());
+		else if (option == "--x" && ++i < argc)
+			valid = valid && parseRange(value, xRange);
+		else if (option == "--z" && ++i < argc)
+			valid = valid && parseRange(value, zRange);
+		else
+			valid = false;
+	}
+
+	valid = valid && width > 0 && spacing > 0 && screenResolutionWidth > 0 && barrierResolutionWidth > 0;
+	if (!valid)
+	{
+		fprintf(stderr, "usage: CrosstalkSweep --width w --spacing s --screen W --barrier W "
+			"[--eye-separation d] [--x min,max,steps] [--z min,max,steps] [--tracking-error dx] [--threads n]\n");
+		return 1;
+	}
+
+	ParallaxBarrierRasterizer rasterizer(width, screenResolutionWidth, barrierResolutionWidth, spacing, ofVec3f(0, 0, 0), ofVec3f(0, 0, 1), ofVec3f(0, 1, 0));
+	ParallaxBarrierCrosstalk crosstalk(width, spacing, screenResolutionWidth, barrierResolutionWidth);
+
+	vector<ofVec3f> leftEyePositions, rightEyePositions;
+	leftEyePositions.reserve(xRange.steps * zRange.steps);
+	rightEyePositions.reserve(xRange.steps * zRange.steps);
+	for (int z = 0; z < zRange.steps; z++)
+	{
+		for (int x = 0; x < xRange.steps; x++)
+		{
+			ofVec3f center(getRangeValue(xRange, x), 0, getRangeValue(zRange, z));
+			leftEyePositions.push_back(center - ofVec3f(eyeSeparation * 0.5f, 0, 0));
+			rightEyePositions.push_back(center + ofVec3f(eyeSeparation * 0.5f, 0, 0));
+		}
+	}
+
+	vector<CrosstalkResult> results;
+	chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+	crosstalk.sweep(rasterizer, leftEyePositions, rightEyePositions, results, ofVec3f(trackingError, 0, 0), threads);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+	EyeStatistics left, right;
+	int failures = 0;
+	for (vector<CrosstalkResult>::const_iterator it = results.begin(), end = results.end(); it != end; ++it)
+	{
+		//the maps of a failed update belong to an earlier position
+		if (!it->modelUpdated)
+		{
+			failures++;
+			continue;
+		}
+		left.add(it->left);
+		right.add(it->right);
+	}
+
+	int count = max(1, (int) results.size() - failures);
+	printf("%d eye positions in %.3f s (%.0f positions/s), %d without model solution\n", (int) results.size(), seconds, results.size() / max(seconds, 0.000001), failures);
+	left.print("left", count);
+	right.print("right", count);
+
+	return 0;
+}
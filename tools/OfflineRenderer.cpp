@@ -0,0 +1,311 @@
+// Headless offline renderer
+// Computes barrier/screen images (or only their column maps) for every sample of a
+// recorded eye trajectory, without windows, OpenGL or OpenCL. Samples are processed
+// in parallel as fast as the machine allows.
+//
+// usage: OfflineRenderer --trajectory eyes.txt --output outputDir [options]
+//   --width w                   physical screen width
+//   --spacing s                 physical screen to barrier distance
+//   --screen WxH                screen resolution
+//   --barrier WxH               barrier resolution
+//   --position x,y,z            screen center (default 0,0,0)
+//   --view x,y,z                screen view direction (default 0,0,1)
+//   --up x,y,z                  screen up direction (default 0,1,0)
+//   --left file --right file    source frames, a printf pattern (e.g. left_%05d.png) 
+//                               selects one frame per sample
+//   --maps                      write column maps (screen bytes, then barrier bytes) instead of images
+//   --inverted                  inverted barrier
+//   --threads n                 worker threads (default: hardware concurrency), image files are
+//                               read and written by one worker at a time
+//
+// trajectory files hold one sample per line: 'time lx ly lz rx ry rz', '#' starts a comment,
+// binary eye traces (see EyeTrace) are read as well
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <string>
+
+#include "ofImage.h"
+#include "ofUtils.h"
+
+#include "ParallaxBarrierRasterizer.h"
+#include "ParallaxBarrierCompositor.h"
+#include "EyeTrace.h"
+
+using namespace std;
+
+struct EyeSample
+{
+	double time;
+	ofVec3f leftEyePosition;
+	ofVec3f rightEyePosition;
+};
+
+struct RenderSettings
+{
+	float width;
+	float spacing;
+	int screenResolutionWidth, screenResolutionHeight;
+	int barrierResolutionWidth, barrierResolutionHeight;
+	ofVec3f position, viewDirection, upDirection;
+	string trajectoryFileName;
+	string leftFileName, rightFileName;
+	string outputDirectory;
+	bool mapsOnly;
+	bool invertedBarrier;
+	int threads;
+};
+
+static bool parseVector(const string &value, ofVec3f &vector)
+{
+	return sscanf(value.c_str(), "%f,%f,%f", &vector.x, &vector.y, &vector.z) == 3;
+}
+
+static bool parseResolution(const string &value, int &width, int &height)
+{
+	return sscanf(value.c_str(), "%dx%d", &width, &height) == 2;
+}
+
+static bool loadTrajectory(const string &fileName, vector<EyeSample> &samples)
+{
+	EyeTraceReader trace;
+	if (trace.open(fileName))
+	{
+		samples.resize(trace.getRecordCount());
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			const EyeTraceRecord &record = trace.getRecord(i);
+			samples[i].time = (record.time - trace.getRecord(0).time) * 0.000001;
+			samples[i].leftEyePosition = record.getLeftEyePosition();
+			samples[i].rightEyePosition = record.getRightEyePosition();
+		}
+		return true;
+	}
+
+	ifstream in(fileName.c_str());
+	if (!in)
+		return false;
+
+	string line;
+	while (getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		EyeSample sample;
+		istringstream values(line);
+		values >> sample.time 
+			>> sample.leftEyePosition.x >> sample.leftEyePosition.y >> sample.leftEyePosition.z
+			>> sample.rightEyePosition.x >> sample.rightEyePosition.y >> sample.rightEyePosition.z;
+		if (values.fail())
+			return false;
+
+		samples.push_back(sample);
+	}
+
+	return true;
+}
+
+static string formatFileName(const string &pattern, int index)
+{
+	char fileName[1024];
+	snprintf(fileName, sizeof(fileName), pattern.c_str(), index);
+	return fileName;
+}
+
+// image loading/saving (FreeImage) is not thread safe, workers take turns
+static mutex imageMutex;
+
+static bool isPattern(const string &fileName)
+{
+	return fileName.find('%') != string::npos;
+}
+
+// views must have the eye resolution: the screen height, at most the screen width, same size and channels for both eyes
+static bool checkViews(const RenderSettings &settings, const ofPixels &leftPixels, const ofPixels &rightPixels)
+{
+	return leftPixels.getWidth() > 0 && (int) leftPixels.getWidth() <= settings.screenResolutionWidth 
+		&& (int) leftPixels.getHeight() == settings.screenResolutionHeight
+		&& leftPixels.getWidth() == rightPixels.getWidth() && leftPixels.getHeight() == rightPixels.getHeight() 
+		&& leftPixels.getNumChannels() == rightPixels.getNumChannels();
+}
+
+static void renderSamples(const RenderSettings &settings, const vector<EyeSample> &samples, const ofPixels &fixedLeftPixels, const ofPixels &fixedRightPixels, atomic<int> &nextSample, atomic<int> &failedSamples, atomic<int> &failedFrames)
+{
+	//each worker owns its rasterizer, model state is not shared
+	ParallaxBarrierRasterizer rasterizer(settings.width, settings.screenResolutionWidth, settings.barrierResolutionWidth, settings.spacing, settings.position, settings.viewDirection, settings.upDirection);
+
+	ofPixels leftPixels, rightPixels, screenPixels, barrierPixels;
+	screenPixels.allocate(settings.screenResolutionWidth, settings.screenResolutionHeight, OF_IMAGE_COLOR);
+	barrierPixels.allocate(settings.barrierResolutionWidth, settings.barrierResolutionHeight, OF_IMAGE_GRAYSCALE);
+
+	for (int i = nextSample++; i < (int) samples.size(); i = nextSample++)
+	{
+		if (!rasterizer.update(samples[i].leftEyePosition, samples[i].rightEyePosition, settings.invertedBarrier))
+		{
+			failedSamples++;
+		}
+
+		if (settings.mapsOnly)
+		{
+			string fileName = formatFileName(settings.outputDirectory + "/maps_%06d.bin", i);
+			ofstream out(fileName.c_str(), ios::out | ios::trunc | ios::binary);
+			out.write((const char*) rasterizer.getScreenPoints(), rasterizer.getScreenResolutionWidth());
+			out.write((const char*) rasterizer.getBarrierPoints(), rasterizer.getBarrierResolutionWidth());
+			out.close();
+			if (out.fail())
+			{
+				fprintf(stderr, "sample %d: could not write '%s'\n", i, fileName.c_str());
+				failedFrames++;
+			}
+			continue;
+		}
+
+		const ofPixels *left = &fixedLeftPixels, *right = &fixedRightPixels;
+		bool loaded = true;
+		if (isPattern(settings.leftFileName) || isPattern(settings.rightFileName))
+		{
+			lock_guard<mutex> lock(imageMutex);
+			if (isPattern(settings.leftFileName))
+			{
+				loaded = ofLoadImage(leftPixels, formatFileName(settings.leftFileName, i)) && loaded;
+				left = &leftPixels;
+			}
+			if (isPattern(settings.rightFileName))
+			{
+				loaded = ofLoadImage(rightPixels, formatFileName(settings.rightFileName, i)) && loaded;
+				right = &rightPixels;
+			}
+		}
+
+		if (!loaded || !checkViews(settings, *left, *right) || !ParallaxBarrierCompositor::compositeScreen(rasterizer.getScreenPoints(), *left, *right, screenPixels))
+		{
+			fprintf(stderr, "sample %d: source frames missing or not matching the eye resolution\n", i);
+			failedFrames++;
+			continue;
+		}
+		ParallaxBarrierCompositor::compositeBarrier(rasterizer.getBarrierPoints(), barrierPixels);
+
+		lock_guard<mutex> lock(imageMutex);
+		ofSaveImage(screenPixels, formatFileName(settings.outputDirectory + "/screen_%06d.png", i));
+		ofSaveImage(barrierPixels, formatFileName(settings.outputDirectory + "/barrier_%06d.png", i));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	RenderSettings settings;
+	settings.width = 0;
+	settings.spacing = 0;
+	settings.screenResolutionWidth = settings.screenResolutionHeight = 0;
+	settings.barrierResolutionWidth = settings.barrierResolutionHeight = 0;
+	settings.position = ofVec3f(0, 0, 0);
+	settings.viewDirection = ofVec3f(0, 0, 1);
+	settings.upDirection = ofVec3f(0, 1, 0);
+	settings.mapsOnly = false;
+	settings.invertedBarrier = false;
+	settings.threads = max(1, (int) thread::hardware_concurrency());
+
+	bool valid = true;
+	for (int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		string value = i + 1 < argc? argv[i + 1] : "";
+
+		if (option == "--maps")
+			settings.mapsOnly = true;
+		else if (option == "--inverted")
+			settings.invertedBarrier = true;
+		else if (option == "--trajectory" && ++i < argc)
+			settings.trajectoryFileName = value;
+		else if (option == "--output" && ++i < argc)
+			settings.outputDirectory = value;
+		else if (option == "--left" && ++i < argc)
+			settings.leftFileName = value;
+		else if (option == "--right" && ++i < argc)
+			settings.rightFileName = value;
+		else if (option == "--width" && ++i < argc)
+			settings.width = (float) atof(value.c_str());
+		else if (option == "--spacing" && ++i < argc)
+			settings.spacing = (float) atof(value.c_str());
+		else if (option == "--threads" && ++i < argc)
+			settings.threads = max(1, atoi(value.c_str()));
+		else if (option == "--screen" && ++i < argc)
+			valid = valid && parseResolution(value, settings.screenResolutionWidth, settings.screenResolutionHeight);
+		else if (option == "--barrier" && ++i < argc)
+			valid = valid && parseResolution(value, settings.barrierResolutionWidth, settings.barrierResolutionHeight);
+		else if (option == "--position" && ++i < argc)
+			valid = valid && parseVector(value, settings.position);
+		else if (option == "--view" && ++i < argc)
+			valid = valid && parseVector(value, settings.viewDirection);
+		else if (option == "--up" && ++i < argc)
+			valid = valid && parseVector(value, settings.upDirection);
+		else
+			valid = false;
+	}
+
+	valid = valid && settings.width > 0 && settings.spacing > 0 
+		&& settings.screenResolutionWidth > 0 && settings.screenResolutionHeight > 0 
+		&& settings.barrierResolutionWidth > 0 && settings.barrierResolutionHeight > 0
+		&& !settings.trajectoryFileName.empty() && !settings.outputDirectory.empty()
+		&& (settings.mapsOnly || (!settings.leftFileName.empty() && !settings.rightFileName.empty()));
+	if (!valid)
+	{
+		fprintf(stderr, "usage: OfflineRenderer --trajectory file --output dir --width w --spacing s --screen WxH --barrier WxH "
+			"[--position x,y,z] [--view x,y,z] [--up x,y,z] [--left file --right file | --maps] [--inverted] [--threads n]\n");
+		return 1;
+	}
+
+	vector<EyeSample> samples;
+	if (!loadTrajectory(settings.trajectoryFileName, samples))
+	{
+		fprintf(stderr, "could not read trajectory '%s'\n", settings.trajectoryFileName.c_str());
+		return 1;
+	}
+
+	//source frames shared by all samples are loaded once
+	ofPixels fixedLeftPixels, fixedRightPixels;
+	if (!settings.mapsOnly)
+	{
+		if ((!isPattern(settings.leftFileName) && !ofLoadImage(fixedLeftPixels, settings.leftFileName)) 
+			|| (!isPattern(settings.rightFileName) && !ofLoadImage(fixedRightPixels, settings.rightFileName)))
+		{
+			fprintf(stderr, "could not read source frames\n");
+			return 1;
+		}
+		if (!isPattern(settings.leftFileName) && !isPattern(settings.rightFileName) && !checkViews(settings, fixedLeftPixels, fixedRightPixels))
+		{
+			fprintf(stderr, "source frames do not match the eye resolution\n");
+			return 1;
+		}
+	}
+
+	atomic<int> nextSample(0), failedSamples(0), failedFrames(0);
+	unsigned long long startTime = ofGetElapsedTimeMicros();
+
+	vector<thread> workers;
+	for (int i = 0; i < settings.threads; i++)
+	{
+		workers.push_back(thread(renderSamples, ref(settings), ref(samples), ref(fixedLeftPixels), ref(fixedRightPixels), ref(nextSample), ref(failedSamples), ref(failedFrames)));
+	}
+	for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		it->join();
+	}
+
+	double seconds = (ofGetElapsedTimeMicros() - startTime) * 0.000001;
+	printf("%d samples in %.3f s (%.1f samples/s), %d without model solution\n", (int) samples.size(), seconds, samples.size() / max(seconds, 0.000001), (int) failedSamples);
+	if (failedFrames > 0)
+	{
+		fprintf(stderr, "%d samples not written (missing source frames or write errors)\n", (int) failedFrames);
+		return 1;
+	}
+
+	return 0;
+}
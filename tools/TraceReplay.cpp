@@ -0,0 +1,146 @@
+// Eye trace replay
+// Replays a binary eye trace (see EyeTrace, recorded with 'e' or ParallaxBarrierApp::eyeTraceFileName)
+// through the model and rasterizer, one record after the other as fast as possible or at the
+// recorded rate. Column maps of every record are hashed, equal hashes mean equal maps, so runs
+// on different machines or builds can be compared. Recorded frame timings are summarized.
+//
+// usage: TraceReplay --trace eyes.etrc --width w --spacing s --screen W --barrier W [options]
+//   --position x,y,z            screen center (default 0,0,0)
+//   --view x,y,z                screen view direction (default 0,0,1)
+//   --up x,y,z                  screen up direction (default 0,1,0)
+//   --inverted                  inverted barrier
+//   --realtime                  wait for the recorded time of each record
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EyeTrace.h"
+#include "FrameTimings.h"
+#include "ParallaxBarrierRasterizer.h"
+
+using namespace std;
+
+static bool parseVector(const string &value, ofVec3f &vector)
+{
+	return sscanf(value.c_str(), "%f,%f,%f", &vector.x, &vector.y, &vector.z) == 3;
+}
+
+// FNV-1a
+static unsigned long long hashBytes(const signed char* bytes, int count, unsigned long long hash)
+{
+	for (int i = 0; i < count; i++)
+	{
+		hash = (hash ^ (unsigned char) bytes[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+int main(int argc, char *argv[])
+{
+	string traceFileName;
+	float width = 0, spacing = 0;
+	int screenResolutionWidth = 0, barrierResolutionWidth = 0;
+	ofVec3f position(0, 0, 0), viewDirection(0, 0, 1), upDirection(0, 1, 0);
+	bool invertedBarrier = false, realtime = false;
+
+	bool valid = true;
+	for (int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		string value = i + 1 < argc? argv[i + 1] : "";
+
+		if (option == "--inverted")
+			invertedBarrier = true;
+		else if (option == "--realtime")
+			realtime = true;
+		else if (option == "--trace" && ++i < argc)
+			traceFileName = value;
+		else if (option == "--width" && ++i < argc)
+			width = (float) atof(value.c_str());
+		else if (option == "--spacing" && ++i < argc)
+			spacing = (float) atof(value.c_str());
+		else if (option == "--screen" && ++i < argc)
+			screenResolutionWidth = atoi(value.c_str());
+		else if (option == "--barrier" && ++i < argc)
+			barrierResolutionWidth = atoi(value.c_str());
+		else if (option == "--position" && ++i < argc)
+			valid = valid && parseVector(value, position);
+		else if (option == "--view" && ++i < argc)
+			valid = valid && parseVector(value, viewDirection);
+		else if (option == "--up" && ++i < argc)
+			valid = valid && parseVector(value, upDirection);
+		else
+			valid = false;
+	}
+
+	valid = valid && !traceFileName.empty() && width > 0 && spacing > 0 && screenResolutionWidth > 0 && barrierResolutionWidth > 0;
+	if (!valid)
+	{
+		fprintf(stderr, "usage: TraceReplay --trace file --width w --spacing s --screen W --barrier W "
+			"[--position x,y,z] [--view x,y,z] [--up x,y,z] [--inverted] [--realtime]\n");
+		return 1;
+	}
+
+	EyeTraceReader trace;
+	if (!trace.open(traceFileName))
+	{
+		fprintf(stderr, "could not read eye trace '%s'\n", traceFileName.c_str());
+		return 1;
+	}
+
+	ParallaxBarrierRasterizer rasterizer(width, screenResolutionWidth, barrierResolutionWidth, spacing, position, viewDirection, upDirection);
+
+	typedef chrono::steady_clock clock;
+	clock::time_point startTime = clock::now();
+	unsigned long long hash = 14695981039346656037ULL;
+	int failures = 0;
+	for (size_t i = 0; i < trace.getRecordCount(); i++)
+	{
+		const EyeTraceRecord &record = trace.getRecord(i);
+		if (realtime)
+		{
+			this_thread::sleep_until(startTime + chrono::microseconds(record.time - trace.getRecord(0).time));
+		}
+
+		if (!rasterizer.update(record.getLeftEyePosition(), record.getRightEyePosition(), invertedBarrier))
+			failures++;
+
+		hash = hashBytes(rasterizer.getScreenPoints(), screenResolutionWidth, hash);
+		hash = hashBytes(rasterizer.getBarrierPoints(), barrierResolutionWidth, hash);
+	}
+	double seconds = chrono::duration<double>(clock::now() - startTime).count();
+
+	printf("%d records (%.1f s recorded) in %.3f s (%.0f records/s), %d without model solution\n", 
+		(int) trace.getRecordCount(), trace.getDuration() * 0.000001, seconds, trace.getRecordCount() / max(seconds, 0.000001), failures);
+	printf("column map hash: %016llx\n", hash);
+
+	if (trace.getStageCount() == FRAME_TIMING_STAGES)
+	{
+		vector<FrameTiming> timings(trace.getRecordCount());
+		for (size_t i = 0; i < timings.size(); i++)
+		{
+			timings[i].frameId = trace.getFrameId(i);
+			timings[i].frameTime = trace.getRecord(i).time;
+			for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+			{
+				timings[i].stages[stage] = trace.getStageTime(i, stage);
+			}
+		}
+
+		const float percentiles[] = { 0.5f, 0.95f, 0.99f, 1.f };
+		printf("%-24s %8s %8s %8s %8s\n", "recorded stage (us)", "p50", "p95", "p99", "max");
+		for (int stage = 0; stage < FRAME_TIMING_STAGES; stage++)
+		{
+			unsigned long long values[4];
+			FrameTimings::getPercentiles(timings, stage, percentiles, values, 4);
+			printf("%-24s %8llu %8llu %8llu %8llu\n", FrameTimings::getStageName(stage), values[0], values[1], values[2], values[3]);
+		}
+	}
+
+	return 0;
+}